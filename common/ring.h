@@ -0,0 +1,149 @@
+/*
+ * ring.h
+ *
+ * 단일 생산자/단일 소비자(SPSC) 바이트 링 버퍼 (헤더 전용, freeRtos_uart / pump_pj 공용)
+ *
+ * 크기는 컴파일 시간에 정하는 2의 거듭제곱(2~256)이어야 하며, 인덱스는 % 대신 마스크로 계산합니다.
+ * 한 칸은 비워 두므로 실제 용량은 크기 - 1 바이트입니다.
+ * 생산자(push/put/commit)와 소비자(pop)가 각각 한 곳(ISR 또는 Task)일 때 잠금 없이 안전합니다.
+ * head는 생산자만, tail은 소비자만 씁니다 (AVR에서 8비트 쓰기는 원자적).
+ *
+ *   RING_DECLARE(uart_tx_ring_t, 256);	// 타입 선언 (헤더)
+ *   uart_tx_ring_t tx_ring;				// 정의 (0으로 초기화되면 빈 링)
+ *   ring_push(&tx_ring, data);
+ */
+
+
+#ifndef RING_H_
+#define RING_H_
+
+#include <stdint.h>
+
+// 데이터 접근과 인덱스 순서를 컴파일러가 바꾸지 못하게 함
+// 공개 쪽: data[] 기록/읽기를 마친 뒤 head/tail 갱신. 확인 쪽: head/tail을 읽은 뒤 data[] 접근
+// (Task가 루프로 폴링해도 data[] 읽기가 head 확인 앞으로 올라가거나 이전 값이 재사용되지 않음)
+#define RING_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+typedef struct {
+	volatile uint8_t head;		// 다음에 쓸 위치 (생산자)
+	volatile uint8_t tail;		// 다음에 읽을 위치 (소비자)
+	uint8_t high_water;			// 최대 사용량 (생산자가 갱신)
+	uint8_t overruns;			// 가득 차서 버린 push 횟수 (255에서 멈춤, 생산자가 갱신)
+} ring_state_t;
+
+// size 바이트 링 타입 선언. size가 2의 거듭제곱이 아니면 컴파일 오류
+#define RING_DECLARE(type, size) \
+	_Static_assert((size) >= 2 && (size) <= 256 && ((size) & ((size) - 1)) == 0, \
+		#type ": ring size must be a power of two between 2 and 256"); \
+	typedef struct { ring_state_t s; uint8_t data[size]; } type
+
+#define RING_MASK(r)	((uint8_t)(sizeof((r)->data) - 1))
+
+// 사용 중인 바이트 수 / 남은 공간
+#define ring_used(r)	ring_used_(&(r)->s, RING_MASK(r))
+#define ring_free(r)	((uint8_t)(RING_MASK(r) - ring_used(r)))
+#define ring_is_empty(r)	((r)->s.head == (r)->s.tail)
+
+// 1바이트 넣기/꺼내기. 가득 찼거나 비었으면 0을 반환합니다.
+#define ring_push(r, byte)	ring_push_(&(r)->s, (r)->data, RING_MASK(r), (byte))
+#define ring_pop(r, out)	ring_pop_(&(r)->s, (r)->data, RING_MASK(r), (out))
+
+// 여러 바이트 넣기/꺼내기. 실제 처리한 바이트 수를 반환합니다 (공간이 모자라 잘리면 overruns 증가).
+#define ring_push_bulk(r, src, n)	ring_push_bulk_(&(r)->s, (r)->data, RING_MASK(r), (src), (n))
+#define ring_pop_bulk(r, dst, n)	ring_pop_bulk_(&(r)->s, (r)->data, RING_MASK(r), (dst), (n))
+
+// 2단계 넣기: put으로 head 뒤에 복사만 하고(ring_free() >= n 확인 필요), commit으로 소비자에게 공개.
+// 공개 시점을 다른 동작(예: RS-485 방향 전환)과 같은 임계 구역에 묶을 때 사용합니다.
+#define ring_put(r, src, n)	ring_put_(&(r)->s, (r)->data, RING_MASK(r), (src), (n))
+#define ring_commit(r, n)	ring_commit_(&(r)->s, RING_MASK(r), (n))
+
+#define ring_reset_stats(r)	((r)->s.high_water = 0, (r)->s.overruns = 0)
+
+static inline uint8_t ring_used_(const ring_state_t *s, uint8_t mask) {
+	return (uint8_t)(s->head - s->tail) & mask;
+}
+
+static inline void ring_overrun_(ring_state_t *s) {
+	if (s->overruns != 0xFF) {
+		s->overruns++;
+	}
+}
+
+static inline void ring_put_(ring_state_t *s, uint8_t *data, uint8_t mask, const uint8_t *src, uint8_t n) {
+	uint8_t head = s->head;
+
+	while (n-- > 0) {
+		data[head] = *src++;
+		head = (head + 1) & mask;
+	}
+}
+
+static inline void ring_commit_(ring_state_t *s, uint8_t mask, uint8_t n) {
+	uint8_t used;
+
+	RING_BARRIER();
+	s->head = (s->head + n) & mask;
+	used = ring_used_(s, mask);
+	if (used > s->high_water) {
+		s->high_water = used;
+	}
+}
+
+static inline uint8_t ring_push_(ring_state_t *s, uint8_t *data, uint8_t mask, uint8_t byte) {
+	uint8_t head = s->head;
+	uint8_t next = (head + 1) & mask;
+
+	if (next == s->tail) {
+		ring_overrun_(s);
+		return 0;
+	}
+	RING_BARRIER();
+	data[head] = byte;
+	ring_commit_(s, mask, 1);
+	return 1;
+}
+
+static inline uint8_t ring_pop_(ring_state_t *s, const uint8_t *data, uint8_t mask, uint8_t *out) {
+	uint8_t tail = s->tail;
+
+	if (tail == s->head) {
+		return 0;
+	}
+	RING_BARRIER();
+	*out = data[tail];
+	RING_BARRIER();
+	s->tail = (tail + 1) & mask;
+	return 1;
+}
+
+static inline uint8_t ring_push_bulk_(ring_state_t *s, uint8_t *data, uint8_t mask, const uint8_t *src, uint8_t n) {
+	uint8_t space = mask - ring_used_(s, mask);
+
+	if (n > space) {
+		ring_overrun_(s);
+		n = space;
+	}
+	RING_BARRIER();
+	ring_put_(s, data, mask, src, n);
+	ring_commit_(s, mask, n);
+	return n;
+}
+
+static inline uint8_t ring_pop_bulk_(ring_state_t *s, const uint8_t *data, uint8_t mask, uint8_t *dst, uint8_t n) {
+	uint8_t tail = s->tail;
+	uint8_t used = ring_used_(s, mask);
+
+	if (n > used) {
+		n = used;
+	}
+	RING_BARRIER();
+	for (uint8_t i = 0; i < n; i++) {
+		*dst++ = data[tail];
+		tail = (tail + 1) & mask;
+	}
+	RING_BARRIER();
+	s->tail = tail;
+	return n;
+}
+
+#endif /* RING_H_ */
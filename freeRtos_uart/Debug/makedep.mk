@@ -6,8 +6,6 @@ FreeRTOS\croutine.c
 
 FreeRTOS\event_groups.c
 
-FreeRTOS\heap_1.c
-
 FreeRTOS\list.c
 
 FreeRTOS\port.c
@@ -18,12 +16,20 @@ FreeRTOS\tasks.c
 
 FreeRTOS\timers.c
 
+crc16.c
+
+dose_queue.c
+
+frame.c
+
 main.c
 
 motor.c
 
 protocol.c
 
+task_stats.c
+
 timer.c
 
 uart.c
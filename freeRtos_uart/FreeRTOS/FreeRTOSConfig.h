@@ -71,6 +71,7 @@
 #define FREERTOS_CONFIG_H
 
 #include <avr/io.h>
+#include <stdint.h>
 
 /*-----------------------------------------------------------
  * Application specific definitions.
@@ -86,18 +87,28 @@
 
 #define configUSE_PREEMPTION		1
 #define configUSE_IDLE_HOOK			0
-#define configUSE_TICK_HOOK			0
+#define configUSE_TICK_HOOK			1
 #define configCPU_CLOCK_HZ			( ( unsigned long ) 16000000 )
 #define configTICK_RATE_HZ			( ( TickType_t ) 1000 )
 #define configMAX_PRIORITIES		( 4 )
 #define configMINIMAL_STACK_SIZE	( ( unsigned short ) 85 )
-#define configTOTAL_HEAP_SIZE		( (size_t ) ( 800 ) )
 #define configMAX_TASK_NAME_LEN		( 8 )
-#define configUSE_TRACE_FACILITY	0
+#define configUSE_TRACE_FACILITY	1
 #define configUSE_16_BIT_TICKS		1
 #define configIDLE_SHOULD_YIELD		1
 #define configQUEUE_REGISTRY_SIZE	0
 
+/* 힙 없음: Task 스택/TCB는 main.c의 정적 버퍼 (heap_1.c는 빌드에서 제외). */
+#define configSUPPORT_STATIC_ALLOCATION		1
+#define configSUPPORT_DYNAMIC_ALLOCATION	0
+
+/* Run time stats: timer.c의 micros() (Tick 타이머 Timer1 + Tick 수, 4us 분해능)를 그대로 사용.
+Timer1은 포트가 스케줄러 시작 때 설정하므로 따로 설정할 타이머가 없음. */
+#define configGENERATE_RUN_TIME_STATS	1
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()	micros()
+uint32_t micros(void);
+
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES 		0
 #define configMAX_CO_ROUTINE_PRIORITIES ( 2 )
@@ -112,6 +123,9 @@ to exclude the API function. */
 #define INCLUDE_vTaskSuspend			1
 #define INCLUDE_vTaskDelayUntil			1
 #define INCLUDE_vTaskDelay				1
+#define INCLUDE_xTaskGetCurrentTaskHandle	1
+#define INCLUDE_xTaskGetIdleTaskHandle	1
+#define INCLUDE_xTaskGetSchedulerState	1
 
 
 #endif /* FREERTOS_CONFIG_H */
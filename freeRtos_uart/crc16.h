@@ -0,0 +1,27 @@
+/*
+ * crc16.h
+ *
+ * CRC-16/MODBUS (다항식 0x8005 반사형 0xA001, 초기값 0xFFFF) 테이블 방식 계산
+ * 수신 바이트마다 crc16_update()를 호출하면, 데이터 뒤에 CRC(하위, 상위 바이트 순)까지
+ * 넣었을 때 결과가 0이 되므로 프레임 끝에서 O(1)로 검증할 수 있습니다.
+ */ 
+
+
+#ifndef CRC16_H_
+#define CRC16_H_
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+#define CRC16_INIT	0xFFFF
+
+extern const uint16_t crc16_table[256] PROGMEM;
+
+// 바이트 1개 반영 (ISR에서도 사용하므로 인라인)
+static inline uint16_t crc16_update(uint16_t crc, uint8_t data) {
+	return (crc >> 8) ^ pgm_read_word(&crc16_table[(uint8_t)(crc ^ data)]);
+}
+
+uint16_t crc16_calculate(const uint8_t *buffer, uint8_t length);
+
+#endif /* CRC16_H_ */
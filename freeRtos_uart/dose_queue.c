@@ -0,0 +1,109 @@
+/*
+ * dose_queue.c
+ *
+ * 투여 작업 큐. 작업은 SPSC 링 버퍼(common/ring.h)에 DOSE_JOB_SIZE 바이트씩 들어가며,
+ * 생산자는 Protocol Task('Q' 명령), 소비자는 Tick Hook입니다.
+ * 별도 Task 없이 tick마다 현재 작업의 상태만 확인하므로 tick당 비용은 비교 몇 번입니다.
+ * 대기가 끝난 작업의 펌프는 나눗셈과 프로파일 읽기가 들어가는 motor_dose_volume()을 부르므로
+ * ISR에서 켜지 않고, Tick Hook의 알림을 받은 Protocol Task가 dose_queue_service()에서 켭니다.
+ */ 
+
+#include "FreeRTOS/FreeRTOS.h"
+#include "FreeRTOS/task.h"
+#include "../common/ring.h"
+#include "motor.h"
+#include "dose_queue.h"
+
+RING_DECLARE(dose_ring_t, DOSE_QUEUE_RING_SIZE);
+
+static dose_ring_t dose_ring;
+
+// 현재 작업 (Tick Hook 소유, STARTING 동안은 Protocol Task 소유.
+// 상태 레지스터 읽기와 dose_queue_clear()는 인터럽트를 막고 접근)
+static volatile uint8_t queue_state = DOSE_QUEUE_IDLE;
+static uint8_t current_job[DOSE_JOB_SIZE];
+static uint16_t wait_ticks;			// 남은 대기 시간 (tick)
+static volatile uint16_t jobs_done;	// 끝낸 작업 수 (0xFFFF 다음 0으로 순환)
+
+uint8_t dose_queue_push(const uint8_t *job) {
+	if (job[DOSE_JOB_CHANNEL] >= MOTOR_CHANNEL_COUNT || ring_free(&dose_ring) < DOSE_JOB_SIZE) {
+		return 0;
+	}
+	// 작업 전체를 복사한 뒤 한 번에 공개 (Tick Hook이 반쯤 쓴 작업을 꺼내지 않음)
+	ring_put(&dose_ring, job, DOSE_JOB_SIZE);
+	ring_commit(&dose_ring, DOSE_JOB_SIZE);
+	return 1;
+}
+
+void dose_queue_clear(void) {
+	taskENTER_CRITICAL();
+	// tail은 소비자(Tick Hook) 인덱스지만, tick 인터럽트를 막은 동안에는 여기서 옮겨도 안전
+	dose_ring.s.tail = dose_ring.s.head;
+	if (queue_state == DOSE_QUEUE_RUNNING) {	// STARTING이면 아직 펌프를 켜지 않음
+		motor_dose_stop(current_job[DOSE_JOB_CHANNEL]);
+	}
+	queue_state = DOSE_QUEUE_IDLE;
+	taskEXIT_CRITICAL();
+}
+
+uint16_t dose_queue_stat(uint8_t id) {
+	switch (id) {
+	case DOSE_STAT_DEPTH:
+		return ring_used(&dose_ring) / DOSE_JOB_SIZE;
+	case DOSE_STAT_STATE:
+		return queue_state;
+	case DOSE_STAT_JOB:
+		if (queue_state == DOSE_QUEUE_IDLE) {
+			return 0;
+		}
+		return current_job[DOSE_JOB_CHANNEL] | ((uint16_t)current_job[DOSE_JOB_VOLUME] << 8);
+	case DOSE_STAT_DONE:
+		return jobs_done;
+	}
+	return 0;
+}
+
+// tick ISR 문맥: 비교와 링 버퍼 복사만 하고, 펌프를 켜는 계산은 Protocol Task에 넘김
+uint8_t dose_queue_tick(void) {
+	switch (queue_state) {
+	case DOSE_QUEUE_IDLE:
+		if (ring_used(&dose_ring) < DOSE_JOB_SIZE) {
+			return 0;
+		}
+		ring_pop_bulk(&dose_ring, current_job, DOSE_JOB_SIZE);
+		wait_ticks = (uint16_t)current_job[DOSE_JOB_DELAY] * (DOSE_QUEUE_DELAY_UNIT_MS / portTICK_PERIOD_MS);
+		queue_state = DOSE_QUEUE_WAITING;
+		/* fall through */
+	case DOSE_QUEUE_WAITING:
+		if (wait_ticks != 0) {
+			wait_ticks--;
+			return 0;
+		}
+		if (current_job[DOSE_JOB_VOLUME] == 0) {
+			// 대기만 하는 작업: 같은 채널에서 'D' 명령으로 투여 중이어도 펌프를 건드리지 않고 완료
+			jobs_done++;
+			queue_state = DOSE_QUEUE_IDLE;
+			return 0;
+		}
+		queue_state = DOSE_QUEUE_STARTING;
+		return 1;
+	case DOSE_QUEUE_RUNNING:
+		// 'D' 명령이 같은 채널을 덮어쓰면 그 투여가 끝날 때 함께 끝남
+		if (motor_dose_is_active(current_job[DOSE_JOB_CHANNEL])) {
+			return 0;
+		}
+		jobs_done++;
+		queue_state = DOSE_QUEUE_IDLE;
+		return 0;
+	}
+	return 0;	// STARTING: Protocol Task가 펌프를 켤 때까지 대기
+}
+
+void dose_queue_service(void) {
+	if (queue_state != DOSE_QUEUE_STARTING) {
+		return;
+	}
+	// STARTING 동안 Tick Hook은 작업을 건드리지 않고, dose_queue_clear()는 같은 Task라 겹치지 않음
+	motor_dose_volume(current_job[DOSE_JOB_CHANNEL], current_job[DOSE_JOB_VOLUME]);
+	queue_state = DOSE_QUEUE_RUNNING;
+}
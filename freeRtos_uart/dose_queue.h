@@ -0,0 +1,50 @@
+/*
+ * dose_queue.h
+ *
+ * 투여 작업 큐: Master가 레시피(채널, 투여량, 앞 작업 뒤 대기 시간)를 'Q' 명령으로 한꺼번에 넣으면
+ * Tick Hook이 순서대로 실행합니다. 실행 중에도 Protocol Task는 버스에 계속 응답합니다.
+ * 펌프를 켜는 계산(투여량 환산, 프로파일)은 Tick Hook의 알림을 받은 Protocol Task가 합니다.
+ */ 
+
+
+#ifndef DOSE_QUEUE_H_
+#define DOSE_QUEUE_H_
+
+#include <stdint.h>
+#include "protocol.h"
+
+// 작업 1개 = DOSE_JOB_SIZE 바이트 ('Q' 프레임과 같은 배치)
+#define DOSE_JOB_CHANNEL		0	// 펌프 채널
+#define DOSE_JOB_VOLUME			1	// 투여량 (mL, 0이면 대기만 하고 펌프는 건드리지 않음)
+#define DOSE_JOB_DELAY			2	// 앞 작업이 끝난 뒤(큐가 비어 있었으면 넣은 뒤) 기다릴 시간 (DOSE_QUEUE_DELAY_UNIT_MS 단위)
+#define DOSE_JOB_SIZE			3
+
+#define DOSE_QUEUE_DELAY_UNIT_MS	100	// 대기 시간 단위 (최대 25.5초)
+#define DOSE_QUEUE_RING_SIZE	32	// 작업 링 버퍼 크기 (바이트, 2의 거듭제곱)
+#define DOSE_QUEUE_CAPACITY		((DOSE_QUEUE_RING_SIZE - 1) / DOSE_JOB_SIZE)	// 대기할 수 있는 작업 수
+
+// DOSE_STAT_STATE 값
+enum {
+	DOSE_QUEUE_IDLE,		// 실행 중인 작업 없음
+	DOSE_QUEUE_WAITING,		// 현재 작업의 대기 시간을 세는 중
+	DOSE_QUEUE_RUNNING,		// 현재 작업 투여 중
+	DOSE_QUEUE_STARTING		// 대기가 끝나 Protocol Task가 펌프를 켜기를 기다리는 중
+};
+
+// Protocol Task 전용: 작업 1개를 큐 끝에 넣습니다. 큐가 가득 찼거나 채널이 잘못되었으면 0을 반환합니다.
+uint8_t dose_queue_push(const uint8_t *job);
+
+// Protocol Task 전용: 대기 중인 작업을 모두 버리고, 실행 중인 작업의 펌프를 멈춥니다.
+void dose_queue_clear(void);
+
+// 상태 레지스터 값 (DOSE_STAT_*). 호출자가 인터럽트를 막은 상태에서 부릅니다.
+uint16_t dose_queue_stat(uint8_t id);
+
+// FreeRTOS tick 훅에서 매 tick 호출 (motor_dose_tick() 다음): 대기 시간을 세고 끝난 작업 다음 작업을 꺼냄
+// 펌프를 켤 작업이 생기면 1을 반환합니다 (Tick Hook이 Protocol Task에 알림).
+uint8_t dose_queue_tick(void);
+
+// Protocol Task 전용: 대기를 마친 작업이 있으면 펌프를 켭니다 (없으면 비교 한 번).
+void dose_queue_service(void);
+
+#endif /* DOSE_QUEUE_H_ */
@@ -0,0 +1,195 @@
+/*
+ * frame.c
+ *
+ * RX ISR에서 바이트 단위로 구동되는 '$' ... '\n' 프레임 조립 상태 머신
+ * (기존 vRxTask -> xUartQueue -> vProtocolTask 경로를 대체)
+ *
+ * 프레임 슬롯 2개를 번갈아 사용합니다 (더블 버퍼).
+ * ISR은 한 슬롯에 바로 바이트를 채우고, '\n'을 받으면 슬롯 번호만 넘깁니다.
+ * Task가 이전 프레임을 처리하는 동안 다음 프레임은 다른 슬롯에 수신됩니다.
+ * PROTOCOL_USE_ESCAPE이면 ESC 바이트를 여기서 풀어 슬롯에는 복원된 프레임만 남깁니다.
+ * 수신 중 '$'를 받거나 바이트 사이가 PROTOCOL_FRAME_TIMEOUT_MS 이상 끊기면 부분 프레임을 버리고
+ * 다시 동기를 맞춥니다 (손상된 프레임 하나가 다음 정상 프레임까지 삼키지 않도록).
+ * 이스케이프가 없으면 데이터/체크섬도 '$'일 수 있으므로, 명령으로 정해지는 길이 안의 그 자리에 온 '$'는
+ * 데이터로 받습니다 (기존 Master가 보내는 0x24 데이터/체크섬 프레임 호환).
+ * SlaveId가 다른 프레임은 ID 바이트에서 버려 슬롯/알림/process_packet() 비용을 쓰지 않습니다.
+ */ 
+
+#include "FreeRTOS/FreeRTOS.h"
+#include "frame.h"
+#include "crc16.h"
+
+#define FRAME_SLOT_COUNT	2
+#define FRAME_SLOT_NONE		0xFF
+#define FRAME_TIMEOUT_TICKS	(PROTOCOL_FRAME_TIMEOUT_MS / portTICK_PERIOD_MS)
+
+// 수신 상태 (IDLE: '$' 대기, RECEIVING: '\n' 대기)
+static enum { STATE_IDLE, STATE_RECEIVING } frame_state = STATE_IDLE;
+
+static uint8_t frame_slots[FRAME_SLOT_COUNT][PROTOCOL_BUFFER_SIZE];
+static uint8_t frame_length[FRAME_SLOT_COUNT];
+static uint8_t frame_index = 0;
+static uint8_t frame_silence_ticks = 0;	// 마지막 수신 바이트 이후 지난 Tick 수
+#if PROTOCOL_USE_CRC16
+static uint16_t frame_crc;	// '$' 다음 바이트부터 바이트마다 갱신 (CRC 바이트까지 넣으면 0)
+#endif
+#if PROTOCOL_USE_ESCAPE
+static uint8_t frame_escaped;	// 직전 바이트가 ESC였음
+#endif
+
+static volatile uint8_t frame_fill_slot = 0;				// ISR이 채우는 슬롯 (NONE이면 빈 슬롯이 없어 바이트를 버림)
+static volatile uint8_t frame_ready_slot = FRAME_SLOT_NONE;	// 완성되어 Task를 기다리는 슬롯
+static volatile uint8_t frame_user_slot = FRAME_SLOT_NONE;	// Task가 처리 중인 슬롯
+static uint8_t frame_lost_start;	// 빈 슬롯이 없을 때 받은 직전 바이트가 '$'였음
+
+#if !PROTOCOL_USE_ESCAPE
+// 수신 중 받은 '$'가 이 프레임의 데이터/체크섬 자리이면 1 ('$'를 받은 바이트로 넣고 길이를 구함)
+// SlaveId(MY_SLAVE_ID는 '$'가 아님), 명령, 개수 자리의 '$'는 유효한 프레임이 될 수 없고,
+// '\n' 자리나 그 뒤의 '$'는 '\n'이 빠진 프레임 뒤의 새 프레임이므로 0
+static uint8_t frame_dollar_is_data(uint8_t slot) {
+	uint8_t length;
+
+	if (frame_state != STATE_RECEIVING || frame_index <= FRAME_IDX_ID || frame_index >= PROTOCOL_BUFFER_SIZE) {
+		return 0;
+	}
+	frame_slots[slot][frame_index] = '$';
+	length = protocol_frame_length(frame_slots[slot], frame_index + 1);
+	if (length == FRAME_LENGTH_INVALID) {
+		return 0;
+	}
+	return length == FRAME_LENGTH_UNKNOWN || frame_index < length - 1;
+}
+#endif
+
+uint8_t frame_rx_byte(uint8_t data) {
+	uint8_t slot = frame_fill_slot;
+	uint8_t payload = (data != '\n');	// '\n'이 아니면 프레임 내용
+	uint8_t other;
+
+	frame_silence_ticks = 0;
+
+	// 두 슬롯이 모두 사용 중이면 바이트를 버립니다.
+	// 버린 프레임은 '$' 다음 바이트가 MY_SLAVE_ID일 때 한 번만 셈 (다른 Slave 앞 트래픽은 세지 않음)
+	if (slot == FRAME_SLOT_NONE) {
+		if (frame_lost_start && data == MY_SLAVE_ID) {
+			COMM_STAT_INC(COMM_STAT_RX_OVERFLOW);
+		}
+		frame_lost_start = (data == '$');
+		return 0;
+	}
+	frame_lost_start = 0;
+
+	// '$' (시작 문자)는 새 프레임 시작 (수신 중이던 부분 프레임은 버림)
+	// 이스케이프가 없으면 데이터/체크섬 자리의 '$'는 아래에서 데이터로 받음
+#if PROTOCOL_USE_ESCAPE
+	if (data == '$') {
+#else
+	if (data == '$' && !frame_dollar_is_data(slot)) {
+#endif
+		frame_index = 0;
+		frame_slots[slot][frame_index++] = data;
+		frame_state = STATE_RECEIVING;
+#if PROTOCOL_USE_CRC16
+		frame_crc = CRC16_INIT;
+#endif
+#if PROTOCOL_USE_ESCAPE
+		frame_escaped = 0;
+#endif
+		return 0;
+	}
+
+	if (frame_state == STATE_IDLE) {
+		return 0;
+	}
+
+#if PROTOCOL_USE_ESCAPE
+	if (frame_escaped) {
+		frame_escaped = 0;
+		if (!payload) {
+			// ESC 바로 뒤의 '\n': 손상된 프레임
+			COMM_STAT_INC(COMM_STAT_BAD_CHECKSUM);
+			frame_state = STATE_IDLE;
+			return 0;
+		}
+		data ^= FRAME_ESCAPE_XOR;
+	} else if (data == FRAME_ESCAPE) {
+		frame_escaped = 1;
+		return 0;
+	}
+#endif
+
+	// 패킷 조립 (슬롯에 직접 기록)
+	if (frame_index >= PROTOCOL_BUFFER_SIZE) {
+		// 버퍼 오버플로우. 패킷 무시하고 리셋
+		COMM_STAT_INC(COMM_STAT_RX_OVERFLOW);
+		frame_state = STATE_IDLE;
+		return 0;
+	}
+	frame_slots[slot][frame_index++] = data;
+
+	if (payload) {
+		// 다른 Slave의 프레임은 ID 바이트에서 바로 버리고 다음 '$'까지 무시
+		if (frame_index == FRAME_IDX_ID + 1 && data != MY_SLAVE_ID) {
+			COMM_STAT_INC(COMM_STAT_FOREIGN_ID);
+			frame_state = STATE_IDLE;
+			return 0;
+		}
+#if PROTOCOL_USE_CRC16
+		frame_crc = crc16_update(frame_crc, data);
+#endif
+		return 0;
+	}
+
+	// '\n' (종료 문자) 수신 시 IDLE 상태로 복귀
+	frame_state = STATE_IDLE;
+
+#if PROTOCOL_USE_CRC16
+	// CRC 오류 프레임은 Task에 넘기지 않음 (두 번째 계산 없이 O(1) 검증)
+	if (frame_crc != 0) {
+		COMM_STAT_INC(COMM_STAT_BAD_CHECKSUM);
+		return 0;
+	}
+#endif
+
+	// 이전 완성 프레임을 Task가 아직 가져가지 않았다면 이번 프레임은 버리고 같은 슬롯을 재사용
+	if (frame_ready_slot != FRAME_SLOT_NONE) {
+		COMM_STAT_INC(COMM_STAT_FRAME_DROPPED);
+		return 0;
+	}
+
+	// 완성된 슬롯을 넘기고, Task가 쓰고 있지 않은 다른 슬롯으로 전환
+	frame_length[slot] = frame_index;
+	frame_ready_slot = slot;
+	other = slot ^ 1;
+	frame_fill_slot = (other == frame_user_slot) ? FRAME_SLOT_NONE : other;
+	return 1;
+}
+
+void frame_tick(void) {
+	if (frame_state == STATE_RECEIVING && ++frame_silence_ticks > FRAME_TIMEOUT_TICKS) {
+		COMM_STAT_INC(COMM_STAT_FRAME_TIMEOUT);
+		frame_state = STATE_IDLE;
+	}
+}
+
+uint8_t *frame_take(uint8_t *length) {
+	uint8_t slot;
+
+	// 이전에 넘겨준 슬롯을 반환 (ISR이 멈춰 있었다면 이 슬롯부터 다시 채움)
+	if (frame_user_slot != FRAME_SLOT_NONE) {
+		if (frame_fill_slot == FRAME_SLOT_NONE) {
+			frame_fill_slot = frame_user_slot;
+		}
+		frame_user_slot = FRAME_SLOT_NONE;
+	}
+
+	slot = frame_ready_slot;
+	if (slot == FRAME_SLOT_NONE) {
+		return NULL;
+	}
+
+	frame_ready_slot = FRAME_SLOT_NONE;
+	frame_user_slot = slot;
+	*length = frame_length[slot];
+	return frame_slots[slot];
+}
@@ -0,0 +1,28 @@
+/*
+ * frame.h
+ *
+ * RX ISR에서 바이트 단위로 구동되는 '$' ... '\n' 프레임 조립 상태 머신
+ */ 
+
+
+#ifndef FRAME_H_
+#define FRAME_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "protocol.h"
+
+// ISR 전용: 수신 바이트 1개를 상태 머신에 넣습니다.
+// 완전한 프레임이 준비되면 1, 그 외에는 0을 반환합니다.
+uint8_t frame_rx_byte(uint8_t data);
+
+// Tick Hook (ISR 문맥) 전용: 프레임 수신 중 PROTOCOL_FRAME_TIMEOUT_MS 동안 바이트가 없으면
+// 부분 프레임을 버리고 '$' 대기로 돌아갑니다.
+void frame_tick(void);
+
+// Task 전용 (임계 구역 안에서 호출): 이전에 받은 슬롯을 반환하고, 준비된 프레임 슬롯의
+// 포인터와 길이를 넘깁니다 (복사 없음). 준비된 프레임이 없으면 NULL을 반환합니다.
+// 반환된 슬롯은 다음 frame_take() 호출 전까지 ISR이 덮어쓰지 않습니다.
+uint8_t *frame_take(uint8_t *length);
+
+#endif /* FRAME_H_ */
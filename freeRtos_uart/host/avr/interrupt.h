@@ -0,0 +1,17 @@
+/*
+ * avr/interrupt.h (host mock)
+ *
+ * ISR(vector)는 같은 이름의 일반 함수로 정의되며, 시뮬레이터가 직접 호출합니다.
+ */ 
+
+
+#ifndef HOST_AVR_INTERRUPT_H_
+#define HOST_AVR_INTERRUPT_H_
+
+#include <avr/io.h>
+
+#define ISR(vector)		void vector(void); void vector(void)
+#define cli()
+#define sei()
+
+#endif /* HOST_AVR_INTERRUPT_H_ */
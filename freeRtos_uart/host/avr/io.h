@@ -0,0 +1,74 @@
+/*
+ * avr/io.h (host mock)
+ *
+ * 호스트(Linux) 빌드용 대체 헤더. 펌웨어 소스를 AVR 툴체인 없이 컴파일하기 위해
+ * 필요한 최소한의 정의만 제공합니다.
+ * I/O 레지스터는 일반 전역 변수로 대체합니다 (sim.c).
+ */ 
+
+
+#ifndef HOST_AVR_IO_H_
+#define HOST_AVR_IO_H_
+
+#include <stdint.h>
+
+// USART0
+extern volatile uint8_t UDR0, UCSR0A, UCSR0B, UCSR0C, UBRR0H, UBRR0L;
+
+#define MPCM0	0
+#define U2X0	1
+#define UPE0	2
+#define DOR0	3
+#define FE0		4
+#define UDRE0	5
+#define TXC0	6
+#define RXC0	7
+
+#define TXB80	0
+#define RXB80	1
+#define UCSZ02	2
+#define TXEN0	3
+#define RXEN0	4
+#define UDRIE0	5
+#define TXCIE0	6
+#define RXCIE0	7
+
+#define UCSZ00	1
+#define UCSZ01	2
+
+// GPIO
+extern volatile uint8_t PORTB, DDRB, PINB, PORTC, DDRC, PINC, PORTD, DDRD, PIND;
+
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PC0 0
+#define PC1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+
+// Timer0
+extern volatile uint8_t TCCR0A, TCCR0B, TIMSK0, TIFR0, TCNT0, OCR0A, OCR0B;
+
+#define CS00	0
+#define CS01	1
+#define CS02	2
+#define TOIE0	0
+#define TOV0	0
+#define WGM00	0
+#define WGM01	1
+#define COM0B1	5
+#define COM0A1	7
+
+// 핀 변화 인터럽트
+extern volatile uint8_t PCICR, PCMSK1;
+
+#define PCIE1	1
+#define PCINT8	0
+#define PCINT9	1
+
+#endif /* HOST_AVR_IO_H_ */
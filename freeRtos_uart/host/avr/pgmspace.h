@@ -0,0 +1,22 @@
+/*
+ * avr/pgmspace.h (host mock)
+ *
+ * 호스트에는 별도의 Flash 주소 공간이 없으므로 PROGMEM 데이터를 일반 메모리로 읽습니다.
+ */ 
+
+
+#ifndef HOST_AVR_PGMSPACE_H_
+#define HOST_AVR_PGMSPACE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s)					(s)
+#define pgm_read_byte(addr)		(*(const uint8_t *)(addr))
+#define pgm_read_word(addr)		(*(const uint16_t *)(addr))
+#define pgm_read_dword(addr)	(*(const uint32_t *)(addr))
+#define pgm_read_ptr(addr)		(*(void * const *)(addr))
+#define memcpy_P				memcpy
+
+#endif /* HOST_AVR_PGMSPACE_H_ */
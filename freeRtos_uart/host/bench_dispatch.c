@@ -0,0 +1,139 @@
+/*
+ * bench_dispatch.c
+ *
+ * process_packet() 디스패치 비용 측정 (호스트 빌드)
+ * 기존 if/else 방식(legacy_process_packet)과 디스패치 테이블 방식을
+ * 같은 프레임 묶음으로 비교하여 프레임당 호스트 TSC 사이클을 출력합니다.
+ */ 
+
+#include <stdio.h>
+#include <stdint.h>
+#include <x86intrin.h>
+
+#include "../uart.h"
+#include "../motor.h"
+#include "../protocol.h"
+
+#define BENCH_ITERATIONS	1000000UL
+
+extern uint8_t g_device_registers[DEVICE_REGISTER_COUNT];
+
+static volatile uint32_t tx_bytes = 0;
+
+// 송신 경로 대체: 바이트 수만 셉니다.
+void uart_tx_frame(const uint8_t *data, uint8_t length) {
+	(void)data;
+	tx_bytes += length;
+}
+
+void uart_change_baud_after_tx(uint32_t baud, uint16_t timeout_ms) {
+	(void)baud;
+	(void)timeout_ms;
+}
+
+void uart_baud_confirm(void) {
+}
+
+void task_stats_update(void) {
+}
+
+// 투여 작업 큐 대체: 넣지 않고 상태는 0
+uint8_t dose_queue_push(const uint8_t *job) {
+	(void)job;
+	return 0;
+}
+
+void dose_queue_clear(void) {
+}
+
+uint16_t dose_queue_stat(uint8_t id) {
+	(void)id;
+	return 0;
+}
+
+// 투여 경로 대체: 펌프 구동 없이 성공만 반환합니다.
+uint8_t g_motor_profiles[MOTOR_CHANNEL_COUNT][MOTOR_PROFILE_SIZE];
+
+uint8_t motor_dose_volume(uint8_t channel, uint16_t volume_ml) {
+	(void)volume_ml;
+	return channel < MOTOR_CHANNEL_COUNT;
+}
+
+// 디스패치 테이블 도입 전의 process_packet() (비교 기준)
+static void legacy_process_packet(uint8_t *buffer, uint8_t length) {
+	if (length < 6) return;
+
+	uint8_t slave_id = buffer[FRAME_IDX_ID];
+	if (slave_id != MY_SLAVE_ID) {
+		return;
+	}
+
+	uint8_t cmd = buffer[FRAME_IDX_CMD];
+	uint8_t addr = buffer[FRAME_IDX_ADDR];
+	uint8_t received_checksum;
+	uint8_t data_len_for_checksum;
+
+	if (cmd == 'W') {
+		if (length != 7) return;
+		received_checksum = buffer[FRAME_IDX_W_CHECKSUM];
+		data_len_for_checksum = 4;
+	} else if (cmd == 'R') {
+		if (length != 6) return;
+		received_checksum = buffer[length - 2];
+		data_len_for_checksum = 3;
+	} else {
+		return;
+	}
+
+	if (received_checksum != calculate_checksum(&buffer[FRAME_IDX_ID], data_len_for_checksum)) {
+		return;
+	}
+
+	uint8_t data;
+	if (cmd == 'W') {
+		data = buffer[FRAME_IDX_W_DATA];
+		if (addr < 16) {
+			g_device_registers[addr] = data;
+		}
+		send_response(slave_id, cmd, addr, data);
+	} else {
+		data = 0;
+		if (addr < 16) {
+			data = g_device_registers[addr];
+		}
+		send_response(slave_id, cmd, addr, data);
+	}
+}
+
+typedef void (*dispatch_fn_t)(uint8_t *buffer, uint8_t length);
+
+static uint8_t frame_w[7] = { '$', MY_SLAVE_ID, 'W', 0x05, 0xAA, 0, '\n' };
+static uint8_t frame_r[6] = { '$', MY_SLAVE_ID, 'R', 0x05, 0, '\n' };
+
+static double bench(dispatch_fn_t fn) {
+	uint64_t start = __rdtsc();
+
+	for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+		fn(frame_w, sizeof(frame_w));
+		fn(frame_r, sizeof(frame_r));
+	}
+	return (double)(__rdtsc() - start) / (2.0 * BENCH_ITERATIONS);
+}
+
+int main(void) {
+	frame_w[5] = calculate_checksum(&frame_w[1], 4);
+	frame_r[4] = calculate_checksum(&frame_r[1], 3);
+
+	// 워밍업 및 동작 확인 (W/R 각각 7바이트 응답)
+	tx_bytes = 0;
+	process_packet(frame_w, sizeof(frame_w));
+	process_packet(frame_r, sizeof(frame_r));
+	if (tx_bytes != 14 || g_device_registers[0x05] != 0xAA) {
+		printf("dispatch check failed (tx=%lu)\n", (unsigned long)tx_bytes);
+		return 1;
+	}
+
+	printf("legacy if/else : %6.1f cycles/frame\n", bench(legacy_process_packet));
+	printf("dispatch table : %6.1f cycles/frame\n", bench(process_packet));
+	return 0;
+}
@@ -0,0 +1,148 @@
+/*
+ * bench_protocol.c
+ *
+ * 프로토콜 스택 처리량/지연 측정 (호스트 빌드)
+ * 시나리오별 '$ ID W/R/r ... \n' 스트림을 ISR(USART_RX_vect) -> uart_rx_frame() -> process_packet()
+ * -> send_response() -> ISR(USART_UDRE_vect) 경로로 흘려 보내고 다음을 출력합니다.
+ *   - 처리량 (frames/s, 호스트)
+ *   - 프레임 완성부터 응답 송신 완료까지 p50/p99/max (호스트 사이클)
+ *   - 송신 링 버퍼 최대 사용량 (high-water)
+ *   - 요청 프레임당 RX 인터럽트 수
+ *
+ *   ./bench_protocol [시나리오당 프레임 수]   (기본 200000)
+ */ 
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../uart.h"
+#include "../motor.h"
+#include "../protocol.h"
+#include "sim.h"
+
+#define BENCH_BATCH_FRAMES	64	// sim_run() 한 번에 흘려 보내는 프레임 수
+
+typedef struct {
+	const char *name;
+	uint8_t frame[PROTOCOL_BUFFER_SIZE];
+	uint8_t length;
+} bench_frame_t;
+
+typedef struct {
+	const char *name;
+	const char *script;	// 반복되는 요청 순서 ('W', 'R', 'r', 'x'=다른 Slave ID 요청)
+} bench_scenario_t;
+
+static const bench_scenario_t scenarios[] = {
+	{ "W only",              "W" },
+	{ "R only",              "R" },
+	{ "bulk r x16",          "r" },
+	{ "W/R mix",             "WRRR" },
+	{ "40-node bus (1 of 40 for us)", "Rxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" },
+};
+
+static uint64_t *latencies;
+static uint32_t latency_count;
+
+static void on_latency(uint64_t cycles) {
+	latencies[latency_count++] = cycles;
+}
+
+static int compare_u64(const void *a, const void *b) {
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+	return (x > y) - (x < y);
+}
+
+static uint8_t build_frame(uint8_t *frame, uint8_t kind) {
+	uint8_t payload;
+
+	frame[FRAME_IDX_ID] = MY_SLAVE_ID;
+	switch (kind) {
+	case 'W':
+		frame[FRAME_IDX_CMD] = 'W';
+		frame[FRAME_IDX_ADDR] = 0x05;
+		frame[FRAME_IDX_W_DATA] = 0xAA;
+		payload = 4;
+		break;
+	case 'r':
+		frame[FRAME_IDX_CMD] = 'r';
+		frame[FRAME_IDX_BULK_START] = 0x00;
+		frame[FRAME_IDX_BULK_COUNT] = PROTOCOL_MAX_BULK;
+		payload = 4;
+		break;
+	case 'x':
+		frame[FRAME_IDX_ID] = MY_SLAVE_ID + 1;
+		/* fall through */
+	default:
+		frame[FRAME_IDX_CMD] = 'R';
+		frame[FRAME_IDX_ADDR] = 0x05;
+		payload = 3;
+		break;
+	}
+	return protocol_finish_frame(frame, payload);
+}
+
+static void run_scenario(const bench_scenario_t *scenario, uint32_t frames) {
+	uint8_t frame[PROTOCOL_BUFFER_SIZE];
+	uint8_t sink[SIM_WIRE_CAPACITY];
+	uint8_t length;
+	uint32_t sent = 0;
+	size_t script_length = strlen(scenario->script);
+	struct timespec t0, t1;
+
+	latency_count = 0;
+	sim_reset_stats();
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	while (sent < frames) {
+		for (uint32_t i = 0; i < BENCH_BATCH_FRAMES && sent < frames; i++, sent++) {
+			length = build_frame(frame, scenario->script[sent % script_length]);
+#if PROTOCOL_USE_9BIT
+			sim_wire_address_to_slave(frame[FRAME_IDX_ID]);
+#endif
+			sim_wire_to_slave(frame, length);
+		}
+		sim_run();
+		sim_wire_from_slave(sink, sizeof(sink));
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	double seconds = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	qsort(latencies, latency_count, sizeof(latencies[0]), compare_u64);
+
+	printf("%-30s %10.0f %8lu %8llu %8llu %8llu %6u %6.2f\n",
+		scenario->name,
+		frames / seconds,
+		(unsigned long)latency_count,
+		(unsigned long long)(latency_count ? latencies[latency_count / 2] : 0),
+		(unsigned long long)(latency_count ? latencies[(uint64_t)latency_count * 99 / 100] : 0),
+		(unsigned long long)(latency_count ? latencies[latency_count - 1] : 0),
+		sim_tx_high_water(),
+		(double)sim_rx_interrupts() / frames);
+}
+
+int main(int argc, char **argv) {
+	uint32_t frames = argc > 1 ? strtoul(argv[1], NULL, 10) : 200000UL;
+
+	latencies = malloc(sizeof(latencies[0]) * frames);
+	if (latencies == NULL) {
+		return 1;
+	}
+
+	uart_init(BAUD);
+	motor_init();
+	sim_set_latency_hook(on_latency);
+
+	printf("%-30s %10s %8s %8s %8s %8s %6s %6s\n",
+		"scenario", "frames/s", "answered", "p50", "p99", "max", "tx_hw", "rx_isr");
+	for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+		run_scenario(&scenarios[i], frames);
+	}
+	printf("(latency: frame complete -> response sent, host cycles; tx_hw: tx ring high-water in bytes; rx_isr: RX interrupts per request frame)\n");
+
+	free(latencies);
+	return 0;
+}
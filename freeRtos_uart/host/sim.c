@@ -0,0 +1,276 @@
+/*
+ * sim.c
+ *
+ * RS-485 Slave 펌웨어 호스트 시뮬레이터: 모의 I/O 레지스터, 모의 FreeRTOS API, 버스 모델
+ */ 
+
+#include <setjmp.h>
+#include <time.h>
+#include <x86intrin.h>
+
+#include <avr/io.h>
+#include "../uart.h"
+#include "../motor.h"
+#include "../protocol.h"
+#include "../dose_queue.h"
+#include "../FreeRTOS/FreeRTOS.h"
+#include "../FreeRTOS/task.h"
+
+#include "sim.h"
+
+// -----------------------------------------------------------
+// 1. 모의 I/O 레지스터
+// -----------------------------------------------------------
+volatile uint8_t UDR0, UCSR0A, UCSR0B, UCSR0C, UBRR0H, UBRR0L;
+volatile uint8_t PORTB, DDRB, PINB, PORTC, DDRC, PINC, PORTD, DDRD, PIND;
+volatile uint8_t PCICR, PCMSK1;
+volatile uint8_t TCCR0A, TCCR0B, TIMSK0, TIFR0, TCNT0, OCR0A, OCR0B;
+
+// 펌웨어 ISR (uart.c)
+void USART_RX_vect(void);
+void USART_UDRE_vect(void);
+void USART_TX_vect(void);
+
+// -----------------------------------------------------------
+// 2. 버스 모델
+// -----------------------------------------------------------
+static uint8_t wire_in[SIM_WIRE_CAPACITY];
+static uint8_t wire_in_address[SIM_WIRE_CAPACITY];	// 9번째 비트
+static uint16_t wire_in_head = 0;
+static uint16_t wire_in_tail = 0;
+
+static uint8_t wire_out[SIM_WIRE_CAPACITY];
+static uint16_t wire_out_length = 0;
+
+static jmp_buf sim_idle;
+static uint8_t sim_notified = 0;
+static uint32_t sim_notify_count = 0;
+static uint32_t sim_rx_count = 0;
+static uint64_t sim_frame_start = 0;
+static sim_latency_hook_t sim_latency_hook = NULL;
+static uint8_t sim_in_udre = 0;		// UDRE ISR 실행 중 (송신 공간 알림 구분용)
+static uint32_t sim_tx_wakeup_count = 0;
+static uint32_t sim_proto_run_time = 0;	// Protocol Task가 프레임 처리에 쓴 시간 (us, run time stats 모델)
+static uint32_t sim_suspend_time = 0;	// vTaskSuspendAll() 시점 (이후 Task 누적 시간은 멈춤)
+
+uint64_t sim_cycles(void) {
+	return __rdtsc();
+}
+
+void sim_wire_to_slave(const uint8_t *data, uint16_t length) {
+	for (uint16_t i = 0; i < length && wire_in_head < SIM_WIRE_CAPACITY; i++) {
+		wire_in_address[wire_in_head] = 0;
+		wire_in[wire_in_head++] = data[i];
+	}
+}
+
+void sim_wire_address_to_slave(uint8_t address) {
+	if (wire_in_head < SIM_WIRE_CAPACITY) {
+		wire_in_address[wire_in_head] = 1;
+		wire_in[wire_in_head++] = address;
+	}
+}
+
+uint16_t sim_wire_from_slave(uint8_t *out, uint16_t max) {
+	uint16_t length = wire_out_length < max ? wire_out_length : max;
+
+	for (uint16_t i = 0; i < length; i++) {
+		out[i] = wire_out[i];
+	}
+	wire_out_length = 0;
+	return length;
+}
+
+void sim_set_latency_hook(sim_latency_hook_t hook) {
+	sim_latency_hook = hook;
+}
+
+uint32_t sim_frames_notified(void) {
+	return sim_notify_count;
+}
+
+uint32_t sim_tx_wakeups(void) {
+	return sim_tx_wakeup_count;
+}
+
+uint32_t sim_rx_interrupts(void) {
+	return sim_rx_count;
+}
+
+uint8_t sim_tx_high_water(void) {
+	return tx_ring.s.high_water;
+}
+
+void sim_reset_stats(void) {
+	sim_notify_count = 0;
+	sim_rx_count = 0;
+	sim_tx_wakeup_count = 0;
+	ring_reset_stats(&tx_ring);
+}
+
+// 1바이트 시간(9600bps에서 약 1ms)마다 Tick Hook 호출
+static void sim_tick(void) {
+	motor_dose_tick();
+	if (dose_queue_tick()) {
+		sim_notified = 1; // Protocol Task 알림 (프레임 알림 통계에는 넣지 않음)
+	}
+	uart_tick();
+}
+
+// 버스가 조용한 동안 Protocol Task는 Block되어 있으므로, 투여 작업 알림을 받으면 바로 작업만 시작
+void sim_silence(uint16_t ms) {
+	while (ms-- > 0) {
+		sim_tick();
+		if (sim_notified) {
+			sim_notified = 0;
+			dose_queue_service();
+		}
+	}
+}
+
+// UDRE 인터럽트가 켜져 있는 동안 송신 링 버퍼를 버스로 내보냄
+static void sim_drain_tx(uint16_t max_bytes) {
+	while ((UCSR0B & (1 << UDRIE0)) && max_bytes-- > 0) {
+		sim_in_udre = 1;
+		USART_UDRE_vect();
+		sim_in_udre = 0;
+		if (!(UCSR0B & (1 << UDRIE0))) {
+			break; // 링 버퍼가 비어 UDRE 인터럽트가 꺼짐
+		}
+		if (wire_out_length < SIM_WIRE_CAPACITY) {
+			wire_out[wire_out_length++] = UDR0;
+		}
+	}
+	if (!(UCSR0B & (1 << UDRIE0))) {
+		USART_TX_vect(); // 마지막 바이트 송신 완료
+	}
+}
+
+void sim_run(void) {
+	uint8_t *packet;
+	uint8_t packet_length;
+
+	if (setjmp(sim_idle)) {
+		return; // 버스 입력을 모두 소비하고 Task가 Block됨
+	}
+
+	// vProtocolTask와 같은 루프
+	while (1) {
+		uint16_t sent_before;
+		uint32_t run_start;
+
+		dose_queue_service();
+		packet = uart_rx_frame(&packet_length);
+		if (packet == NULL) {
+			continue;
+		}
+		sent_before = wire_out_length;
+		run_start = micros();
+		process_packet(packet, packet_length);
+		sim_drain_tx(0xFFFF);
+		sim_proto_run_time += micros() - run_start;
+
+		if (sim_latency_hook != NULL && wire_out_length != sent_before) {
+			sim_latency_hook(sim_cycles() - sim_frame_start);
+		}
+	}
+}
+
+// -----------------------------------------------------------
+// 3. 모의 FreeRTOS API (uart.c, motor.c, task_stats.c가 사용하는 것만)
+// -----------------------------------------------------------
+static uint8_t sim_task;
+static uint8_t sim_idle_task;
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+	return (TaskHandle_t)&sim_task;
+}
+
+TaskHandle_t xTaskGetIdleTaskHandle(void) {
+	return (TaskHandle_t)&sim_idle_task;
+}
+
+// run time stats 시간축 (timer.c 대신): 처음 호출 이후 호스트 시간 (us)
+uint32_t micros(void) {
+	static uint64_t base = 0;
+	struct timespec now;
+	uint64_t us;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	us = (uint64_t)now.tv_sec * 1000000u + now.tv_nsec / 1000;
+	if (base == 0) {
+		base = us;
+	}
+	return (uint32_t)(us - base);
+}
+
+// Protocol Task는 sim_run()에서 프레임을 처리한 시간, Idle은 스케줄러를 멈춘 시점까지의 나머지 시간
+void vTaskGetInfo(TaskHandle_t xTask, TaskStatus_t *pxTaskStatus, BaseType_t xGetFreeStackSpace, eTaskState eState) {
+	(void)xGetFreeStackSpace;
+	pxTaskStatus->xHandle = xTask;
+	pxTaskStatus->eCurrentState = eState;
+	if (xTask == (TaskHandle_t)&sim_task) {
+		pxTaskStatus->ulRunTimeCounter = sim_proto_run_time;
+		pxTaskStatus->usStackHighWaterMark = SIM_PROTO_STACK_FREE;
+	} else {
+		pxTaskStatus->ulRunTimeCounter = sim_suspend_time - sim_proto_run_time;
+		pxTaskStatus->usStackHighWaterMark = SIM_IDLE_STACK_FREE;
+	}
+}
+
+void vTaskSuspendAll(void) {
+	sim_suspend_time = micros();
+}
+
+BaseType_t xTaskResumeAll(void) {
+	return pdFALSE;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken) {
+	(void)xTaskToNotify;
+	sim_notified = 1;
+	*pxHigherPriorityTaskWoken = pdTRUE;
+	if (sim_in_udre) {
+		sim_tx_wakeup_count++; // 송신 링 버퍼 공간 알림
+		return;
+	}
+	sim_notify_count++;
+	sim_frame_start = sim_cycles();
+}
+
+// 알림이 올 때까지 송신 중이면 UART가 바이트를 내보내고, 아니면 버스의 다음 바이트를 RX ISR에 넣음.
+// 버스가 비면 sim_run()으로 복귀
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait) {
+	(void)xClearCountOnExit;
+	(void)xTicksToWait;
+
+	while (!sim_notified) {
+		if (UCSR0B & (1 << UDRIE0)) {
+			sim_drain_tx(1);
+			continue;
+		}
+		if (wire_in_tail == wire_in_head) {
+			wire_in_head = 0;
+			wire_in_tail = 0;
+			longjmp(sim_idle, 1);
+		}
+		// 9번째 비트는 RXB80으로, MPCM 중에는 주소 바이트만 수신 완료 인터럽트 발생
+		if (wire_in_address[wire_in_tail]) {
+			UCSR0B |= (1 << RXB80);
+		} else {
+			UCSR0B &= ~(1 << RXB80);
+		}
+		if (wire_in_address[wire_in_tail] || !(UCSR0A & (1 << MPCM0))) {
+			UDR0 = wire_in[wire_in_tail];
+			sim_rx_count++;
+			USART_RX_vect();
+		}
+		wire_in_tail++;
+		sim_tick();
+	}
+	sim_notified = 0;
+	return 1;
+}
+
+void vPortYield(void) {
+}
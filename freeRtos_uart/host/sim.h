@@ -0,0 +1,51 @@
+/*
+ * sim.h
+ *
+ * RS-485 Slave 펌웨어 호스트 시뮬레이터
+ * 실제 uart.c / frame.c / protocol.c / motor.c를 모의 레지스터와 모의 FreeRTOS API 위에서 실행합니다.
+ * 버스에서 들어오는 바이트는 ISR(USART_RX_vect)로, 응답은 ISR(USART_UDRE_vect)가 UDR0에 쓴 값으로 전달됩니다.
+ */ 
+
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <stdint.h>
+
+#define SIM_WIRE_CAPACITY	4096
+
+// 모의 vTaskGetInfo()가 돌려주는 스택 최소 여유 (바이트)
+#define SIM_PROTO_STACK_FREE	42
+#define SIM_IDLE_STACK_FREE		17
+
+// 프레임 완성(ISR 알림)부터 응답 송신 완료까지 걸린 호스트 사이클을 받는 콜백 (응답한 프레임만)
+typedef void (*sim_latency_hook_t)(uint64_t cycles);
+
+// Master -> Slave: 버스에 바이트를 추가합니다 (sim_run()에서 소비).
+void sim_wire_to_slave(const uint8_t *data, uint16_t length);
+
+// Master -> Slave: 9번째 비트가 1인 주소 바이트를 추가합니다 (PROTOCOL_USE_9BIT).
+// MPCM이 켜져 있으면 주소 바이트가 아닌 바이트는 RX ISR을 부르지 않습니다 (하드웨어 필터).
+void sim_wire_address_to_slave(uint8_t address);
+
+// 버스 입력이 모두 소비될 때까지 Protocol Task 루프를 실행합니다.
+void sim_run(void);
+
+// 버스에 아무 바이트도 없는 상태로 ms만큼 Tick을 진행합니다.
+void sim_silence(uint16_t ms);
+
+// Slave -> Master: 지금까지 송신된 바이트를 꺼냅니다. 꺼낸 바이트 수를 반환합니다.
+uint16_t sim_wire_from_slave(uint8_t *out, uint16_t max);
+
+// 통계
+void sim_set_latency_hook(sim_latency_hook_t hook);
+uint32_t sim_frames_notified(void);
+uint32_t sim_rx_interrupts(void);	// RX ISR 호출 횟수
+uint32_t sim_tx_wakeups(void);		// 송신 링 버퍼가 가득 차 Block된 Task를 UDRE ISR이 깨운 횟수
+uint8_t sim_tx_high_water(void);	// 송신 링 버퍼 최대 사용량
+void sim_reset_stats(void);
+
+// 호스트 TSC 사이클
+uint64_t sim_cycles(void);
+
+#endif /* SIM_H_ */
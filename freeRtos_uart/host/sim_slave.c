@@ -0,0 +1,715 @@
+/*
+ * sim_slave.c
+ *
+ * Slave 펌웨어 회귀 검사 하네스 (호스트 빌드)
+ * 무작위 W/R/r/w/D 요청, 다른 Slave ID, 체크섬 오류, 잡음 바이트, '\n'이 빠진 프레임,
+ * 중간에 끊긴 프레임을 버스로 흘려 보내고,
+ * 응답을 참조 모델과 비교합니다. 처리량(frames/s)과 최악 지연(호스트 사이클)을 출력합니다.
+ *
+ *   ./sim_slave [프레임 수]   (기본 1000000)
+ */ 
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../uart.h"
+#include "../motor.h"
+#include "../protocol.h"
+#include "../dose_queue.h"
+#include "sim.h"
+
+extern uint8_t g_device_registers[DEVICE_REGISTER_COUNT];
+
+// 참조 모델의 레지스터
+static uint8_t model_registers[DEVICE_REGISTER_COUNT];
+
+static uint32_t rng_state = 0x12345678;
+static uint64_t latency_max = 0;
+
+static uint8_t rng(void) {
+	rng_state = rng_state * 1103515245u + 12345u;
+	return (uint8_t)(rng_state >> 16);
+}
+
+// 프레임 구분자와 겹치지 않는 바이트 (잡음용)
+static uint8_t rng_noise(void) {
+	uint8_t value;
+
+	do {
+		value = rng();
+	} while (value == '\n' || value == '$');
+	return value;
+}
+
+// 데이터 바이트 (이스케이프가 없으면 '\n'은 프레임을 자르므로 제외)
+static uint8_t rng_data(void) {
+#if PROTOCOL_USE_ESCAPE
+	return rng();
+#else
+	return rng_noise();
+#endif
+}
+
+static void on_latency(uint64_t cycles) {
+	if (cycles > latency_max) {
+		latency_max = cycles;
+	}
+}
+
+// '$' ID ... Checksum '\n' 프레임을 완성합니다 (펌웨어와 같은 체크섬/CRC 설정).
+static uint8_t finish_frame(uint8_t *frame, uint8_t payload_length) {
+	return protocol_finish_frame(frame, payload_length);
+}
+
+// 요청 프레임 완성: ID부터 체크섬까지 '\n'이 있으면 프레임이 잘리므로 0을 반환합니다 (다시 생성).
+// 데이터/체크섬 자리의 '$'는 이스케이프 없이도 데이터로 받아야 하므로 그대로 보냅니다.
+static uint8_t finish_request(uint8_t *frame, uint8_t payload_length) {
+	uint8_t length = finish_frame(frame, payload_length);
+
+#if PROTOCOL_USE_ESCAPE
+	return length; // 버스로 보낼 때 encode_frame()이 이스케이프
+#endif
+	for (uint8_t i = 1; i < length - 1; i++) {
+		if (frame[i] == '\n') {
+			return 0;
+		}
+	}
+	return length;
+}
+
+// 프레임을 버스 바이트열로 변환합니다 (첫/마지막 바이트는 그대로, 그 사이는 이스케이프).
+static uint16_t encode_frame(const uint8_t *frame, uint8_t length, uint8_t *wire) {
+	uint16_t n = 0;
+
+	for (uint8_t i = 0; i < length; i++) {
+		uint8_t data = frame[i];
+		if (PROTOCOL_USE_ESCAPE && i != 0 && i != length - 1 && FRAME_NEEDS_ESCAPE(data)) {
+			wire[n++] = FRAME_ESCAPE;
+			data ^= FRAME_ESCAPE_XOR;
+		}
+		wire[n++] = data;
+	}
+	return n;
+}
+
+// 요청을 버스로 보냅니다 (9비트 모드면 프레임 앞에 주소 바이트).
+static void send_request(const uint8_t *wire, uint16_t length, uint8_t address) {
+#if PROTOCOL_USE_9BIT
+	sim_wire_address_to_slave(address);
+#else
+	(void)address;
+#endif
+	sim_wire_to_slave(wire, length);
+}
+
+static uint8_t clip(uint8_t start, uint8_t count) {
+	if (start >= DEVICE_REGISTER_COUNT) return 0;
+	if (count > DEVICE_REGISTER_COUNT - start) count = DEVICE_REGISTER_COUNT - start;
+	return count;
+}
+
+// 요청 하나를 만들고 기대 응답을 expect에 채웁니다. 요청 길이를 반환합니다 (0이면 다시 생성).
+static uint8_t make_request(uint8_t *frame, uint8_t *expect, uint8_t *expect_length) {
+	uint8_t kind = rng() % 8;
+	uint8_t addr = rng() % (DEVICE_REGISTER_COUNT + 2);
+	uint8_t length;
+	uint8_t count;
+
+	*expect_length = 0;
+	frame[FRAME_IDX_ID] = MY_SLAVE_ID;
+
+	switch (kind) {
+	case 0: // W
+	case 1:
+		frame[FRAME_IDX_CMD] = 'W';
+		frame[FRAME_IDX_ADDR] = addr;
+		frame[FRAME_IDX_W_DATA] = rng_data();
+		length = finish_request(frame, 4);
+		if (length == 0) return 0;
+		if (addr < DEVICE_REGISTER_COUNT) model_registers[addr] = frame[FRAME_IDX_W_DATA];
+		memcpy(expect, frame, 5);
+		break;
+
+	case 2: // R
+	case 3:
+		frame[FRAME_IDX_CMD] = 'R';
+		frame[FRAME_IDX_ADDR] = addr;
+		length = finish_request(frame, 3);
+		if (length == 0) return 0;
+		memcpy(expect, frame, 4);
+		expect[4] = addr < DEVICE_REGISTER_COUNT ? model_registers[addr] : 0;
+		break;
+
+	case 4: // r
+		count = rng() % (PROTOCOL_MAX_BULK + 1);
+		frame[FRAME_IDX_CMD] = 'r';
+		frame[FRAME_IDX_BULK_START] = addr;
+		frame[FRAME_IDX_BULK_COUNT] = count;
+		length = finish_request(frame, 4);
+		if (length == 0) return 0;
+		count = clip(addr, count);
+		memcpy(expect, frame, 4);
+		expect[FRAME_IDX_BULK_COUNT] = count;
+		memcpy(&expect[FRAME_IDX_BULK_DATA], &model_registers[addr < DEVICE_REGISTER_COUNT ? addr : 0], count);
+		*expect_length = finish_frame(expect, FRAME_IDX_BULK_DATA - 1 + count);
+		return length;
+
+	case 5: // w
+		count = rng() % (PROTOCOL_MAX_BULK + 1);
+		frame[FRAME_IDX_CMD] = 'w';
+		frame[FRAME_IDX_BULK_START] = addr;
+		frame[FRAME_IDX_BULK_COUNT] = count;
+		for (uint8_t i = 0; i < count; i++) {
+			frame[FRAME_IDX_BULK_DATA + i] = rng_data();
+		}
+		length = finish_request(frame, FRAME_IDX_BULK_DATA - 1 + count);
+		if (length == 0) return 0;
+		memcpy(expect, frame, 4);
+		expect[FRAME_IDX_BULK_COUNT] = clip(addr, count);
+		memcpy(&model_registers[addr < DEVICE_REGISTER_COUNT ? addr : 0], &frame[FRAME_IDX_BULK_DATA], expect[FRAME_IDX_BULK_COUNT]);
+		*expect_length = finish_frame(expect, 4);
+		return length;
+
+	case 6: // D (채널 0~2, 2는 잘못된 채널)
+		frame[FRAME_IDX_CMD] = 'D';
+		frame[FRAME_IDX_D_CHANNEL] = rng() % (MOTOR_CHANNEL_COUNT + 1);
+		frame[FRAME_IDX_D_VOLUME] = rng_data();
+		length = finish_request(frame, 4);
+		if (length == 0) return 0;
+		memcpy(expect, frame, 5);
+		if (frame[FRAME_IDX_D_CHANNEL] >= MOTOR_CHANNEL_COUNT) expect[FRAME_IDX_D_VOLUME] = 0;
+		break;
+
+	default: // 응답이 없어야 하는 요청: 다른 Slave ID, 체크섬 오류, 잡음, 잘린 프레임
+		frame[FRAME_IDX_CMD] = 'R';
+		frame[FRAME_IDX_ADDR] = addr;
+		length = finish_request(frame, 3);
+		if (length == 0) return 0;
+		switch (rng() % 5) {
+		case 0: frame[FRAME_IDX_ID] = MY_SLAVE_ID + 1 + rng() % 8; break;
+		case 1: frame[4] ^= 0x01; if (frame[4] == '\n') return 0; break;
+		case 2: // '\n'이 빠진 프레임: 다음 프레임의 '$'에서 다시 동기
+			frame[length - 1] = rng_noise();
+			break;
+		case 3: // 주소 앞에서 끊긴 프레임: 나머지가 시간 초과 뒤에 도착하면 버려야 함
+			if (FRAME_NEEDS_ESCAPE(frame[FRAME_IDX_ADDR])) return 0;
+			send_request(frame, FRAME_IDX_ADDR, frame[FRAME_IDX_ID]);
+			sim_run();
+			sim_silence(PROTOCOL_FRAME_TIMEOUT_MS + 1);
+			memmove(frame, &frame[FRAME_IDX_ADDR], length - FRAME_IDX_ADDR);
+			return length - FRAME_IDX_ADDR;
+		default: // '$'와 '\n'이 없는 잡음
+			for (uint8_t i = 0; i < length; i++) frame[i] = rng_noise();
+			break;
+		}
+		return length;
+	}
+
+	*expect_length = finish_frame(expect, 4);
+	return length;
+}
+
+// 송신 링 버퍼보다 긴 출력: UDRE ISR의 low-water 알림으로 이어서 채워 한 바이트도 빠지지 않아야 함
+static uint32_t check_long_print(void) {
+	static char text[1000 + 1];
+	static uint8_t actual[sizeof(text)];
+	uint16_t length;
+
+	for (uint16_t i = 0; i < sizeof(text) - 1; i++) {
+		text[i] = 'A' + i % 26;
+	}
+	sim_reset_stats();
+	uart_task_print(text);
+	sim_run();
+	length = sim_wire_from_slave(actual, sizeof(actual));
+
+	printf("long print  : %u bytes, %lu tx wakeups\n", length, (unsigned long)sim_tx_wakeups());
+	if (length != sizeof(text) - 1 || memcmp(actual, text, length) != 0 || sim_tx_wakeups() == 0) {
+		printf("long print mismatch\n");
+		return 1;
+	}
+	return 0;
+}
+
+// 요청 하나(frame[2]부터 payload가 채워진 상태)를 보내고 이스케이프를 푼 응답을 reply에 받습니다.
+// 응답 길이를 반환합니다 (reply는 PROTOCOL_BUFFER_SIZE 이상).
+static uint8_t exchange(uint8_t *frame, uint8_t payload_length, uint8_t *reply) {
+	uint8_t wire[2 * (PROTOCOL_BUFFER_SIZE + 8)];
+	uint16_t wire_length;
+	uint8_t length = 0;
+
+	frame[FRAME_IDX_ID] = MY_SLAVE_ID;
+	wire_length = encode_frame(frame, finish_frame(frame, payload_length), wire);
+	send_request(wire, wire_length, MY_SLAVE_ID);
+	sim_run();
+	wire_length = sim_wire_from_slave(wire, sizeof(wire));
+
+	// 이스케이프 해제 (PROTOCOL_USE_ESCAPE = 0이면 ESC 바이트가 오지 않으므로 그대로 복사)
+	for (uint16_t i = 0; i < wire_length && length < PROTOCOL_BUFFER_SIZE; i++) {
+		if (PROTOCOL_USE_ESCAPE && wire[i] == FRAME_ESCAPE && i + 1 < wire_length) {
+			reply[length++] = wire[++i] ^ FRAME_ESCAPE_XOR;
+		} else {
+			reply[length++] = wire[i];
+		}
+	}
+	return length;
+}
+
+// r 명령으로 레지스터 count개(최대 PROTOCOL_MAX_BULK)를 읽어 out에 채웁니다. 실패하면 1을 반환합니다.
+static uint32_t read_registers(uint8_t start, uint8_t count, uint8_t *out) {
+	uint8_t frame[PROTOCOL_BUFFER_SIZE + 8];
+	uint8_t reply[PROTOCOL_BUFFER_SIZE + 8];
+	uint8_t length;
+
+	frame[FRAME_IDX_CMD] = 'r';
+	frame[FRAME_IDX_BULK_START] = start;
+	frame[FRAME_IDX_BULK_COUNT] = count;
+	length = exchange(frame, 4, reply);
+	if (length != FRAME_LENGTH(4 + count) || reply[FRAME_IDX_BULK_COUNT] != count) {
+		printf("register read 0x%02X failed (%u bytes)\n", start, length);
+		return 1;
+	}
+	memcpy(out, &reply[FRAME_IDX_BULK_DATA], count);
+	return 0;
+}
+
+// 0x24('$') 데이터와 0x24 체크섬: 이스케이프가 없어도 프레임을 다시 시작하지 않고 처리해야 함
+// (W 0x03 <- 0x24, 체크섬이 0x24가 되는 W, '$' 데이터가 든 w)
+static uint32_t check_dollar_payload(void) {
+	static const uint8_t requests[][8] = {
+		{ 'W', 0x03, '$' },
+		{ 'W', 0x04, 0x00 },			// 체크섬이 '$'가 되도록 아래에서 값 결정
+		{ 'w', 0x05, 0x03, '$', '$', 0x11 },
+	};
+	static const uint8_t payload_lengths[] = { 4, 4, 4 + 3 };
+	uint8_t frame[PROTOCOL_BUFFER_SIZE + 8];
+	uint8_t reply[PROTOCOL_BUFFER_SIZE + 8];
+	uint8_t length;
+
+	for (uint8_t n = 0; n < sizeof(payload_lengths); n++) {
+		memcpy(&frame[FRAME_IDX_CMD], requests[n], payload_lengths[n] - 1);
+		frame[FRAME_IDX_ID] = MY_SLAVE_ID;
+		if (n == 1) {
+			frame[FRAME_IDX_W_DATA] = (uint8_t)('$' - calculate_checksum(&frame[FRAME_IDX_ID], 3));
+		}
+		length = exchange(frame, payload_lengths[n], reply);
+		if (n == 1 && !PROTOCOL_USE_CRC16 && frame[payload_lengths[n] + 1] != '$') {
+			printf("dollar payload: checksum is not '$'\n");
+			return 1;
+		}
+		if (length != FRAME_LENGTH(4) || reply[FRAME_IDX_CMD] != frame[FRAME_IDX_CMD]) {
+			printf("dollar payload: request %u not answered (%u bytes)\n", n, length);
+			return 1;
+		}
+		if (frame[FRAME_IDX_CMD] == 'W') {
+			model_registers[frame[FRAME_IDX_ADDR]] = frame[FRAME_IDX_W_DATA];
+		} else {
+			memcpy(&model_registers[frame[FRAME_IDX_BULK_START]], &frame[FRAME_IDX_BULK_DATA], frame[FRAME_IDX_BULK_COUNT]);
+		}
+	}
+	if (memcmp(g_device_registers, model_registers, DEVICE_REGISTER_COUNT) != 0) {
+		printf("dollar payload: registers differ\n");
+		return 1;
+	}
+	return 0;
+}
+
+// 상태 레지스터(0x80~)를 r 명령으로 읽어 카운터가 실제 흘려 보낸 트래픽과 맞는지 확인
+// 한 번에 PROTOCOL_MAX_BULK 바이트까지만 응답하므로 나누어 읽음
+static uint32_t check_stats(uint32_t responses) {
+	uint8_t data[2 * COMM_STAT_COUNT];
+	uint16_t stats[COMM_STAT_COUNT];
+
+	for (uint8_t offset = 0; offset < sizeof(data); offset += PROTOCOL_MAX_BULK) {
+		uint8_t count = sizeof(data) - offset;
+		if (count > PROTOCOL_MAX_BULK) count = PROTOCOL_MAX_BULK;
+		if (read_registers(STATUS_REGISTER_BASE + offset, count, &data[offset])) {
+			return 1;
+		}
+	}
+	for (uint8_t i = 0; i < COMM_STAT_COUNT; i++) {
+		stats[i] = data[2 * i] | (data[2 * i + 1] << 8);
+	}
+
+	printf("stats       : served %u, foreign %u, checksum %u, length %u, timeout %u, dropped %u, overflow %u\n",
+		stats[COMM_STAT_SERVED], stats[COMM_STAT_FOREIGN_ID], stats[COMM_STAT_BAD_CHECKSUM],
+		stats[COMM_STAT_BAD_LENGTH], stats[COMM_STAT_FRAME_TIMEOUT], stats[COMM_STAT_FRAME_DROPPED],
+		stats[COMM_STAT_RX_OVERFLOW]);
+	// SERVED를 담은 조각보다 앞서 읽은 조각의 응답도 SERVED에 포함됨
+	responses += (2 * COMM_STAT_SERVED) / PROTOCOL_MAX_BULK;
+	if (stats[COMM_STAT_SERVED] != (uint16_t)responses || stats[COMM_STAT_BAD_CHECKSUM] == 0
+			|| stats[COMM_STAT_FRAME_TIMEOUT] == 0 || (!PROTOCOL_USE_9BIT && stats[COMM_STAT_FOREIGN_ID] == 0)) {
+		printf("stats mismatch\n");
+		return 1;
+	}
+	return 0;
+}
+
+// 태스크 상태 레지스터: CPU 사용률 합이 100%에 가깝고, 스택 여유가 모의 값과 같으며,
+// TASK_STATS_WINDOW_MS 안에 다시 읽으면 같은 값이어야 함
+static uint32_t check_task_stats(void) {
+	uint8_t data[2 * TASK_STAT_COUNT];
+	uint8_t again[sizeof(data)];
+	uint16_t stats[TASK_STAT_COUNT];
+	uint16_t cpu;
+
+	if (read_registers(TASK_STAT_REGISTER_BASE, sizeof(data), data)
+			|| read_registers(TASK_STAT_REGISTER_BASE, sizeof(again), again)) {
+		return 1;
+	}
+	for (uint8_t i = 0; i < TASK_STAT_COUNT; i++) {
+		stats[i] = data[2 * i] | (data[2 * i + 1] << 8);
+	}
+	cpu = stats[TASK_STAT_PROTO_CPU] + stats[TASK_STAT_IDLE_CPU];
+
+	printf("task stats  : proto %u.%u%% (stack %u free), idle %u.%u%% (stack %u free)\n",
+		stats[TASK_STAT_PROTO_CPU] / 10, stats[TASK_STAT_PROTO_CPU] % 10, stats[TASK_STAT_PROTO_STACK],
+		stats[TASK_STAT_IDLE_CPU] / 10, stats[TASK_STAT_IDLE_CPU] % 10, stats[TASK_STAT_IDLE_STACK]);
+	if (cpu < 990 || cpu > 1000 || stats[TASK_STAT_PROTO_CPU] == 0
+			|| stats[TASK_STAT_PROTO_STACK] != SIM_PROTO_STACK_FREE || stats[TASK_STAT_IDLE_STACK] != SIM_IDLE_STACK_FREE
+			|| memcmp(data, again, sizeof(data)) != 0) {
+		printf("task stats mismatch\n");
+		return 1;
+	}
+	return 0;
+}
+
+// 채널 0의 출력 상태: PWM이면 비교 레지스터 값(연결이 끊겼으면 0), 아니면 On 255 / Off 0
+static uint8_t pump0_duty(void) {
+#if MOTOR_USE_PWM
+	return (TCCR0A & (1 << COM0A1)) ? OCR0A : 0;
+#else
+	return (PORTB & PIN8_BIT) ? 255 : 0;
+#endif
+}
+
+// 'w'로 채널 0 투여 프로파일을 쓰고 'r'로 다시 읽어 확인합니다. 실패하면 1을 반환합니다.
+static uint32_t write_profile(const uint8_t *profile) {
+	uint8_t frame[PROTOCOL_BUFFER_SIZE + 8];
+	uint8_t reply[PROTOCOL_BUFFER_SIZE + 8];
+
+	frame[FRAME_IDX_CMD] = 'w';
+	frame[FRAME_IDX_BULK_START] = MOTOR_REGISTER_BASE;
+	frame[FRAME_IDX_BULK_COUNT] = MOTOR_PROFILE_SIZE;
+	memcpy(&frame[FRAME_IDX_BULK_DATA], profile, MOTOR_PROFILE_SIZE);
+	exchange(frame, FRAME_IDX_BULK_DATA - 1 + MOTOR_PROFILE_SIZE, reply);
+	if (read_registers(MOTOR_REGISTER_BASE, MOTOR_PROFILE_SIZE, reply) || memcmp(reply, profile, MOTOR_PROFILE_SIZE) != 0) {
+		printf("profile registers mismatch\n");
+		return 1;
+	}
+	return 0;
+}
+
+// 'D' 명령으로 채널 0에 volume_ml 투여를 시작합니다.
+static void send_dose(uint8_t volume_ml) {
+	uint8_t frame[PROTOCOL_BUFFER_SIZE + 8];
+	uint8_t reply[PROTOCOL_BUFFER_SIZE + 8];
+
+	frame[FRAME_IDX_CMD] = 'D';
+	frame[FRAME_IDX_D_CHANNEL] = 0;
+	frame[FRAME_IDX_D_VOLUME] = volume_ml;
+	exchange(frame, 4, reply);
+}
+
+#if !MOTOR_USE_FLOW_SENSOR
+// 투여 프로파일: 'w'로 채널 0 프로파일(최대 속도, 마지막 2.0mL는 duty 64)을 쓰고 'D' 12mL를 보내면
+// 본 구간 -> 마무리 구간 -> 정지가 계산한 시각(±3ms)에 일어나야 함. PWM이 아니면 프로파일 없이 최대 속도.
+static uint32_t check_dose_profile(void) {
+	const double ms_per_ml = 1000.0 * 100 / PUMP_FLOW_CML_PER_S;
+	const uint8_t profile[MOTOR_PROFILE_SIZE] = { 255, 64, 20 };
+	uint32_t bulk_ms, tail_ms;
+	uint8_t duty[4];
+
+#if MOTOR_USE_PWM
+	bulk_ms = (uint32_t)(10 * ms_per_ml + 0.5);
+	tail_ms = (uint32_t)(2 * ms_per_ml * 255 / 64 + 0.5);
+#else
+	bulk_ms = (uint32_t)(12 * ms_per_ml + 0.5);
+	tail_ms = 0;
+#endif
+
+	if (write_profile(profile)) {
+		return 1;
+	}
+	send_dose(12);	// 10('\n')은 이스케이프 없이 보낼 수 없음
+
+	sim_silence(bulk_ms - 3);
+	duty[0] = pump0_duty();		// 본 구간 끝 직전
+	sim_silence(6);
+	duty[1] = pump0_duty();		// 마무리 구간 시작 직후 (PWM이 아니면 정지)
+	if (tail_ms != 0) {
+		sim_silence(tail_ms - 6);
+		duty[2] = pump0_duty();	// 마무리 구간 끝 직전
+		sim_silence(6);
+	} else {
+		duty[2] = 0;
+	}
+	duty[3] = pump0_duty();		// 정지
+
+	printf("dose profile: bulk %lu ms at %u, tail %lu ms at %u, then %u\n",
+		(unsigned long)bulk_ms, duty[0], (unsigned long)tail_ms, duty[2], duty[3]);
+	if (duty[0] != 255 || duty[1] != (MOTOR_USE_PWM ? 64 : 0) || duty[2] != (MOTOR_USE_PWM ? 64 : 0)
+			|| duty[3] != 0 || motor_dose_is_active(0)) {
+		printf("dose profile mismatch\n");
+		return 1;
+	}
+	return 0;
+}
+#endif
+
+// 'Q' 명령으로 작업 count개를 넣습니다. 응답의 (넣은 개수 << 8 | 대기 작업 수)를 반환합니다.
+static uint16_t send_queue(const uint8_t *jobs, uint8_t count) {
+	uint8_t frame[PROTOCOL_BUFFER_SIZE + 8];
+	uint8_t reply[PROTOCOL_BUFFER_SIZE + 8];
+
+	frame[FRAME_IDX_CMD] = 'Q';
+	frame[FRAME_IDX_Q_COUNT] = count;
+	memcpy(&frame[FRAME_IDX_Q_JOBS], jobs, count * DOSE_JOB_SIZE);
+	if (exchange(frame, FRAME_IDX_Q_JOBS - 1 + count * DOSE_JOB_SIZE, reply) != FRAME_LENGTH(4) || reply[FRAME_IDX_CMD] != 'Q') {
+		return 0xFFFF;
+	}
+	return (reply[3] << 8) | reply[4];
+}
+
+// 큐 상태 레지스터를 읽어 stats에 채웁니다. 실패하면 1을 반환합니다.
+static uint32_t read_dose_stats(uint16_t *stats) {
+	uint8_t data[2 * DOSE_STAT_COUNT];
+
+	if (read_registers(DOSE_STAT_REGISTER_BASE, sizeof(data), data)) {
+		return 1;
+	}
+	for (uint8_t i = 0; i < DOSE_STAT_COUNT; i++) {
+		stats[i] = data[2 * i] | (data[2 * i + 1] << 8);
+	}
+	return 0;
+}
+
+// 채널 channel의 투여가 active 상태가 될 때까지 1ms씩 진행하고 걸린 시간(ms)을 반환합니다.
+static uint32_t wait_dose(uint8_t channel, uint8_t active) {
+	uint32_t ms;
+
+	for (ms = 0; ms < 60000 && motor_dose_is_active(channel) != active; ms++) {
+		sim_silence(1);
+	}
+	return ms;
+}
+
+// 투여 작업 큐: 'Q' 한 프레임으로 넣은 레시피(채널 0 12mL, 2초 뒤 채널 1 5mL)를 순서대로 실행하고
+// 진행 상태를 레지스터로 보여야 함. 투여량 0인 작업은 대기만 하고 같은 채널의 'D' 투여를 그대로 둠.
+// 큐가 차면 앞부분만 받고, 잘못된 채널에서 멈추고, 개수 0이면 비움.
+static uint32_t check_dose_queue(void) {
+	const uint8_t recipe[] = { 0, 12, 0,  1, 5, 20 };
+	const uint8_t filler[] = { 0, 1, 1,  0, 1, 1,  0, 1, 1,  0, 1, 1,  0, 1, 1 };
+	const uint8_t invalid[] = { 1, 1, 1,  MOTOR_CHANNEL_COUNT, 1, 1 };
+	const uint8_t wait_only[] = { 0, 0, 5 };
+	uint16_t stats[DOSE_STAT_COUNT], reply, done;
+	uint32_t gap;
+
+	for (uint8_t channel = 0; channel < MOTOR_CHANNEL_COUNT; channel++) {
+		motor_dose_stop(channel);	// 무작위 'D' 요청이 남긴 투여
+	}
+	if (read_dose_stats(stats)) {
+		return 1;
+	}
+	done = stats[DOSE_STAT_DONE];
+
+	reply = send_queue(recipe, 2);
+	sim_silence(1);
+	if (reply != 0x0202 || read_dose_stats(stats) || stats[DOSE_STAT_DEPTH] != 1
+			|| stats[DOSE_STAT_STATE] != DOSE_QUEUE_RUNNING || stats[DOSE_STAT_JOB] != (0 | 12 << 8)
+			|| !motor_dose_is_active(0)) {
+		printf("dose queue: first job not started (reply %04X)\n", reply);
+		return 1;
+	}
+	wait_dose(0, 0);
+	gap = wait_dose(1, 1);
+	if (read_dose_stats(stats) || stats[DOSE_STAT_DEPTH] != 0 || stats[DOSE_STAT_STATE] != DOSE_QUEUE_RUNNING
+			|| stats[DOSE_STAT_JOB] != (1 | 5 << 8) || gap < 2000 || gap > 2002) {
+		printf("dose queue: second job after %lu ms\n", (unsigned long)gap);
+		return 1;
+	}
+	wait_dose(1, 0);
+	sim_silence(1);
+	if (read_dose_stats(stats) || stats[DOSE_STAT_STATE] != DOSE_QUEUE_IDLE || stats[DOSE_STAT_DONE] != (uint16_t)(done + 2)) {
+		printf("dose queue: recipe not finished\n");
+		return 1;
+	}
+
+	// 대기만 하는 작업(투여량 0)은 같은 채널의 'D' 투여를 멈추지 않고 대기 시간 뒤 완료
+	send_dose(12);
+	send_queue(wait_only, 1);
+	sim_silence(DOSE_QUEUE_DELAY_UNIT_MS * wait_only[DOSE_JOB_DELAY] + 2);
+	if (read_dose_stats(stats) || stats[DOSE_STAT_STATE] != DOSE_QUEUE_IDLE || stats[DOSE_STAT_DONE] != (uint16_t)(done + 3)
+			|| !motor_dose_is_active(0)) {
+		printf("dose queue: wait-only job disturbed channel 0 (done %u)\n", stats[DOSE_STAT_DONE]);
+		return 1;
+	}
+	motor_dose_stop(0);
+
+	// 용량: 5개씩 세 번 -> DOSE_QUEUE_CAPACITY개까지만, 잘못된 채널 앞까지만, 개수 0이면 비움
+	reply = send_queue(filler, 5);
+	reply = (send_queue(filler, 5) & 0xFF00) + (reply & 0xFF00) + (send_queue(filler, 5) & 0xFF);
+	if (reply != ((DOSE_QUEUE_CAPACITY << 8) | DOSE_QUEUE_CAPACITY)) {
+		printf("dose queue: capacity %04X\n", reply);
+		return 1;
+	}
+	if (send_queue(NULL, 0) != 0x0000 || send_queue(invalid, 2) != 0x0101) {
+		printf("dose queue: clear/invalid channel mismatch\n");
+		return 1;
+	}
+	send_queue(NULL, 0);
+	sim_silence(1);
+	if (read_dose_stats(stats) || stats[DOSE_STAT_DEPTH] != 0 || stats[DOSE_STAT_STATE] != DOSE_QUEUE_IDLE) {
+		printf("dose queue: not cleared\n");
+		return 1;
+	}
+	printf("dose queue  : recipe done, gap %lu ms, capacity %u jobs\n", (unsigned long)gap, DOSE_QUEUE_CAPACITY);
+	return 0;
+}
+
+#if MOTOR_USE_FLOW_SENSOR
+void PCINT1_vect(void);
+
+// 모의 유량 센서: 펌프를 1ms씩 돌리며 흐른 양(duty에 비례, 최대 속도 1mL당 ms_per_ml)만큼 PC0에 펄스를 넣습니다.
+// 펌프가 멈추거나 max_ms가 지나면 끝내고 걸린 시간(ms)을 반환합니다.
+static uint32_t run_flow(double ms_per_ml, uint32_t max_ms, uint32_t *pulses, uint8_t *tail_seen) {
+	double pending = 0;
+	uint32_t ms;
+
+	for (ms = 0; ms < max_ms && motor_dose_is_active(0); ms++) {
+		uint8_t duty = pump0_duty();
+
+		*tail_seen |= (duty != 0 && duty != 255);
+		pending += duty / 255.0 / ms_per_ml * FLOW_SENSOR_PULSES_PER_L / 1000;
+		while (pending >= 1 && motor_dose_is_active(0)) {
+			PINC |= FLOW_SENSOR0_BIT;
+			PCINT1_vect();
+			PINC &= ~FLOW_SENSOR0_BIT;
+			PCINT1_vect();
+			pending -= 1;
+			(*pulses)++;
+		}
+		sim_silence(1);
+	}
+	return ms;
+}
+
+// 유량 센서 투여: 실제 펌프가 보정값보다 25% 느릴 때
+// - 12mL 투여가 정확히 목표 펄스 수에서 멈추고, 마지막 2.0mL는 마무리 속도로 돌아야 함
+// - 투여를 반복하면 보정값이 실제 유량으로 수렴해야 함 (2% 이내)
+// - 센서 펄스가 없으면 제한 시간에 멈추고 고장으로 세며 보정값은 그대로여야 함
+static uint32_t check_flow_dose(void) {
+	const uint8_t profile[MOTOR_PROFILE_SIZE] = { 255, 64, 20 };
+	const double nominal_ms_per_ml = 1000.0 * 100 / PUMP_FLOW_CML_PER_S;
+	const double actual_ms_per_ml = nominal_ms_per_ml * 1.25;
+	const uint32_t target = (12 * FLOW_SENSOR_PULSES_PER_L + 500) / 1000;
+	uint32_t pulses, elapsed, calibration;
+	uint8_t tail_seen, faults;
+	double calibrated_ms_per_ml;
+
+	if (write_profile(profile)) {
+		return 1;
+	}
+	for (uint8_t n = 0; n < 12; n++) {
+		pulses = 0;
+		tail_seen = 0;
+		send_dose(12);
+		elapsed = run_flow(actual_ms_per_ml, 60000, &pulses, &tail_seen);
+		if (pulses != target || !tail_seen || pump0_duty() != 0 || motor_dose_is_active(0)) {
+			printf("flow dose %u: %lu pulses (expected %lu) in %lu ms, tail %u, duty %u\n", n,
+				(unsigned long)pulses, (unsigned long)target, (unsigned long)elapsed, tail_seen, pump0_duty());
+			return 1;
+		}
+	}
+	calibration = motor_calibration_q16(0);
+	calibrated_ms_per_ml = calibration / 65536.0;
+	printf("flow dose   : %lu pulses, calibration %.1f -> %.1f ms/mL (actual %.1f)\n", (unsigned long)target,
+		nominal_ms_per_ml, calibrated_ms_per_ml, actual_ms_per_ml);
+	if (calibrated_ms_per_ml < actual_ms_per_ml * 0.98 || calibrated_ms_per_ml > actual_ms_per_ml * 1.02) {
+		printf("flow calibration did not converge\n");
+		return 1;
+	}
+
+	// 센서 단선: 펄스 없이 제한 시간(예상 구동 시간의 FLOW_TIMEOUT_FACTOR배)까지 돌고 멈춤
+	faults = motor_flow_faults(0);
+	send_dose(12);
+	for (elapsed = 0; elapsed < 60000 && motor_dose_is_active(0); elapsed++) {
+		sim_silence(1);
+	}
+	printf("flow timeout: stopped after %lu ms\n", (unsigned long)elapsed);
+	if (motor_dose_is_active(0) || pump0_duty() != 0 || motor_flow_faults(0) != (uint8_t)(faults + 1)
+			|| elapsed < (10 + 2 * 255 / 64.0) * calibrated_ms_per_ml * FLOW_TIMEOUT_FACTOR * 0.98
+			|| motor_calibration_q16(0) != calibration) {
+		printf("flow timeout mismatch\n");
+		return 1;
+	}
+	return 0;
+}
+#endif
+
+int main(int argc, char **argv) {
+	uint32_t frames = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000UL;
+	uint8_t frame[PROTOCOL_BUFFER_SIZE + 8];
+	uint8_t expect[PROTOCOL_BUFFER_SIZE + 8];
+	uint8_t actual[SIM_WIRE_CAPACITY];
+	uint8_t request_wire[2 * sizeof(frame)];
+	uint8_t expect_wire[2 * sizeof(expect)];
+	uint8_t frame_length, expect_length;
+	uint16_t actual_length, request_wire_length, expect_wire_length;
+	uint32_t errors = 0, responses = 0;
+	struct timespec t0, t1;
+
+	uart_init(BAUD);
+	motor_init();
+	sim_set_latency_hook(on_latency);
+	errors += check_long_print();
+	sim_reset_stats();
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (uint32_t n = 0; n < frames; n++) {
+		do {
+			frame_length = make_request(frame, expect, &expect_length);
+		} while (frame_length == 0);
+
+		request_wire_length = encode_frame(frame, frame_length, request_wire);
+		expect_wire_length = encode_frame(expect, expect_length, expect_wire);
+
+		send_request(request_wire, request_wire_length, frame[FRAME_IDX_ID]);
+		sim_run();
+		actual_length = sim_wire_from_slave(actual, sizeof(actual));
+
+		if (actual_length != expect_wire_length || memcmp(actual, expect_wire, expect_wire_length) != 0) {
+			if (errors++ < 10) {
+				printf("mismatch at frame %lu (cmd '%c'): expected %u bytes, got %u\n",
+					(unsigned long)n, frame[FRAME_IDX_CMD], expect_wire_length, actual_length);
+			}
+		}
+		responses += (expect_length != 0);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	errors += check_stats(responses);
+	errors += check_task_stats();
+	errors += check_dollar_payload();
+#if MOTOR_USE_FLOW_SENSOR
+	errors += check_flow_dose();
+#else
+	errors += check_dose_profile();
+#endif
+	errors += check_dose_queue();
+
+	if (memcmp(g_device_registers, model_registers, DEVICE_REGISTER_COUNT) != 0) {
+		printf("register map differs from model\n");
+		errors++;
+	}
+
+	double seconds = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	printf("frames      : %lu (%lu answered)\n", (unsigned long)frames, (unsigned long)responses);
+	printf("throughput  : %.0f frames/s (host)\n", frames / seconds);
+	printf("max latency : %llu host cycles (frame complete -> response sent)\n", (unsigned long long)latency_max);
+	printf("tx ring max : %u bytes\n", sim_tx_high_water());
+	printf("result      : %s (%lu mismatches)\n", errors ? "FAIL" : "PASS", (unsigned long)errors);
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,15 @@
+/*
+ * util/atomic.h (host mock)
+ *
+ * 시뮬레이터는 단일 스레드로 ISR을 호출하므로 원자 블록은 일반 블록입니다.
+ */ 
+
+
+#ifndef HOST_UTIL_ATOMIC_H_
+#define HOST_UTIL_ATOMIC_H_
+
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_FORCEON
+#define ATOMIC_BLOCK(type)	for (uint8_t atomic_once__ = 1; atomic_once__; atomic_once__ = 0)
+
+#endif /* HOST_UTIL_ATOMIC_H_ */
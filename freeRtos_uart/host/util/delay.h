@@ -0,0 +1,12 @@
+/*
+ * util/delay.h (host mock)
+ */ 
+
+
+#ifndef HOST_UTIL_DELAY_H_
+#define HOST_UTIL_DELAY_H_
+
+#define _delay_ms(ms)
+#define _delay_us(us)
+
+#endif /* HOST_UTIL_DELAY_H_ */
@@ -6,81 +6,88 @@
 #include "uart.h"
 #include "motor.h"
 #include "protocol.h"
+#include "timer.h"
+#include "dose_queue.h"
 
 
 // FreeRTOS 헤더 파일
 #include "FreeRTOS/FreeRTOS.h"
 #include "FreeRTOS/task.h"
-#include "FreeRTOS/queue.h"
 
-// Task 간 통신을 위한 큐 핸들
-static QueueHandle_t xUartQueue = NULL;
+/*
+ * 정적 할당 (configSUPPORT_STATIC_ALLOCATION, 힙 없음)
+ * Task 스택과 TCB는 모두 크기가 정해진 .bss 객체이므로, SRAM 사용량은 링크 결과(.map, avr-size의
+ * data + bss)에 그대로 나타나고 시작 시 할당 실패가 없습니다.
+ * 링커의 data 영역은 SRAM 2048바이트에서 main() 스택(스케줄러 시작 전에만 사용,
+ * Task/ISR은 각 Task 스택 사용)용 SRAM_MAIN_STACK_RESERVE를 뺀 크기로 제한되어
+ * 정적 객체가 예산을 넘으면 "region `data' overflowed" 링크 오류가 납니다.
+ * avr5 링커 스크립트의 data 영역은 0x800060(I/O 공간 뒤)에서 시작하고 이 값은 바꿀 수 없지만,
+ * ATmega328P의 SRAM과 .data는 0x800100에서 시작하므로 길이에는 그 사이 160바이트를 더합니다:
+ * 2048 - 128 + 160 = 2080 (-Wl,--defsym=__DATA_REGION_LENGTH__=2080: freeRtos_uart.cproj 두 구성의
+ * 링커 옵션과 Debug/Makefile 링크 명령)
+ * 예산을 바꿀 때는 이 값들을 함께 고칩니다.
+ */
+#define SRAM_MAIN_STACK_RESERVE     128
+
+#define PROTO_TASK_STACK_SIZE       (configMINIMAL_STACK_SIZE + 100) // 패킷 처리 로직을 위해 스택 증가
+
+static StackType_t proto_task_stack[PROTO_TASK_STACK_SIZE];
+static StaticTask_t proto_task_tcb;
+static TaskHandle_t proto_task_handle;
+
+static StackType_t idle_task_stack[configMINIMAL_STACK_SIZE];
+static StaticTask_t idle_task_tcb;
 
 /**
- * @brief Rx Task: 수신 링 버퍼 -> FreeRTOS 큐 (원본 코드와 동일)
- * ISR의 링 버퍼에서 바이트를 가져와 처리 태스크용 큐로 전송합니다.
+ * @brief Protocol Task: 완성된 프레임 수신 -> 패킷 처리
+ * RX ISR이 '$' ... '\n' 프레임을 직접 조립하여 프레임 단위로 알려주므로,
+ * 바이트 단위 큐 전달 없이 한 번에 프레임을 받아 처리합니다.
+ * 프레임은 ISR이 채운 슬롯을 그대로 사용하며 (복사 없음), 처리하는 동안
+ * 다음 프레임은 다른 슬롯에 수신됩니다.
  */
-void vRxTask(void *pvParameters) {
-    uint8_t received_char;
-    
+void vProtocolTask(void *pvParameters) {
+    uint8_t *packet;
+    uint8_t packet_length;
+
     while (1) {
-        // uart_rx()는 내부적으로 vTaskDelay(1)을 포함하여
-        // 데이터가 없을 때 CPU를 양보합니다.
-        received_char = uart_rx(); 
-        
-        // 데이터를 FreeRTOS 큐로 전송 (최대 10ms 대기)
-        if (xQueueSend(xUartQueue, &received_char, pdMS_TO_TICKS(10)) != pdPASS) {
-            // 큐 오버런 발생: vProtocolTask가 너무 느림
+        // 1. 대기를 마친 투여 작업이 있으면 펌프 시작 (투여량 환산 계산은 ISR 밖에서)
+        dose_queue_service();
+
+        // 2. 완성된 프레임이나 Tick Hook의 투여 작업 알림이 올 때까지 Block (무기한 대기)
+        packet = uart_rx_frame(&packet_length);
+        if (packet == NULL) {
+            continue;
         }
+
+        // 3. Master의 요청 처리 (다음 uart_rx_frame() 호출 시 슬롯 반환)
+        process_packet(packet, packet_length);
     }
 }
 
 
-
 /**
- * @brief Protocol Task: 큐 -> 패킷 조립 -> 패킷 처리
- * vRxTask가 큐에 넣은 바이트들을 수신하여 프로토콜 패킷을 조립하고 처리합니다.
+ * @brief FreeRTOS Tick Hook (Timer1 Compare A, 1ms마다 ISR 문맥에서 호출)
+ * millis()/micros() 시간축을 진행하고, 투여 중인 펌프의 남은 시간을 줄이고, 완료된 펌프를 정지합니다.
+ * 투여 작업 큐의 대기 시간을 세고, 다음 작업의 펌프를 켤 때가 되면 Protocol Task를 깨웁니다.
+ * 보율 변경 후 확인 대기 시간도 여기서 셉니다.
  */
-void vProtocolTask(void *pvParameters) {
-    uint8_t received_char;
-    uint8_t packet_buffer[PROTOCOL_BUFFER_SIZE];
-    uint8_t packet_index = 0;
-    
-    // 수신 상태 (IDLE: '$' 대기, RECEIVING: '\n' 대기)
-    enum { STATE_IDLE, STATE_RECEIVING } state = STATE_IDLE;
-
-    while (1) {
-        // 1. FreeRTOS 큐에서 데이터 수신 (무기한 대기)
-        if (xQueueReceive(xUartQueue, &received_char, portMAX_DELAY) == pdPASS) {
-            
-            if (state == STATE_IDLE) {
-                // '$' (시작 문자)를 기다림
-                if (received_char == '$') {
-                    packet_index = 0;
-                    packet_buffer[packet_index++] = received_char;
-                    state = STATE_RECEIVING;
-                }
-            } 
-            else if (state == STATE_RECEIVING) {
-                // 패킷 조립
-                if (packet_index < PROTOCOL_BUFFER_SIZE) {
-                    packet_buffer[packet_index++] = received_char;
-                } else {
-                    // 버퍼 오버플로우. 패킷 무시하고 리셋
-                    state = STATE_IDLE;
-                    continue;
-                }
-
-                // '\n' (종료 문자) 수신 시
-                if (received_char == '\n') {
-                    // Master의 요청 처리 
-                    process_packet(packet_buffer, packet_index);
-                    // 다음 패킷을 위해 IDLE 상태로 복귀
-                    state = STATE_IDLE;
-                }
-            }
-        }
+void vApplicationTickHook(void) {
+    timer_tick();
+    motor_dose_tick();
+    if (dose_queue_tick()) {
+        vTaskNotifyGiveFromISR(proto_task_handle, NULL); // NULL: 문맥 전환은 tick ISR이 처리
     }
+    uart_tick();
+}
+
+
+/**
+ * @brief Idle Task 메모리 제공 (configSUPPORT_STATIC_ALLOCATION, vTaskStartScheduler()가 호출)
+ */
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint32_t *pulIdleTaskStackSize) {
+    *ppxIdleTaskTCBBuffer = &idle_task_tcb;
+    *ppxIdleTaskStackBuffer = idle_task_stack;
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
 }
 
 
@@ -89,38 +96,24 @@ int main(void) {
     uart_init(BAUD);
 	//모터 초기화
 	motor_init();
-	timer0_init();
     
-    // 큐 생성: 64개의 8비트(uint8_t) 요소를 저장
-    // 수신 버퍼링을 위해 넉넉하게 설정
-    xUartQueue = xQueueCreate(64, sizeof(uint8_t));
-
-    if (xUartQueue != NULL) {
-		motor_W1();
-
-        // Rx Task 생성 (높은 우선순위: 수신 데이터를 빠르게 링 버퍼에서 큐로 이동)
-        xTaskCreate(
-            vRxTask,
-            "RxTask",
-            configMINIMAL_STACK_SIZE,
-            NULL,
-            tskIDLE_PRIORITY + 2,
-            NULL
-        );
-
-        // Protocol Task 생성 (상대적으로 낮은 우선순위: 패킷 처리)
-        xTaskCreate(
-            vProtocolTask,
-            "ProtoTask", // vTxTask -> vProtocolTask
-            configMINIMAL_STACK_SIZE + 100, // 패킷 처리 로직을 위해 스택 증가
-            NULL,
-            tskIDLE_PRIORITY + 1,
-            NULL
-        );
-        
-        // FreeRTOS 스케줄러 시작
-        vTaskStartScheduler();
-    }
+    // 첫번째 펌프 투여 시작 (블록하지 않음, 정지는 Tick Hook에서 처리)
+    motor_W1();
+
+    // Protocol Task 생성 (RX ISR이 조립한 프레임을 받아 처리)
+    // 정적 버퍼를 넘기므로 실패하지 않음
+    proto_task_handle = xTaskCreateStatic(
+        vProtocolTask,
+        "ProtoTask",
+        PROTO_TASK_STACK_SIZE,
+        NULL,
+        tskIDLE_PRIORITY + 1,
+        proto_task_stack,
+        &proto_task_tcb
+    );
+
+    // FreeRTOS 스케줄러 시작 (Idle Task도 정적 메모리 사용, 반환하지 않음)
+    vTaskStartScheduler();
 
     // 스케줄러가 시작되면 이 부분은 실행되지 않음
     while (1) { }
@@ -1,22 +1,404 @@
 ﻿
 #include <avr/io.h>
+#include <avr/interrupt.h>
 #include "motor.h"
 #include "timer.h"
 #include <util/delay.h>
+#include "FreeRTOS/FreeRTOS.h"
+#include "FreeRTOS/task.h"
 
-//28047ms 모터의 유량 흐름 값
-const float Pump_Flow=3.57;
+//28047ms 모터의 유량 흐름 값 (3.57mL/s)
+//ATmega328P에는 FPU가 없으므로 1mL당 구동 시간(ms)을 Q16.16 고정소수점으로 보관
+//채널마다 따로 두며, 유량 센서가 있으면 투여가 끝날 때마다 측정값으로 갱신
+static uint32_t motor_ms_per_ml_q16[MOTOR_CHANNEL_COUNT] = {
+	[0 ... MOTOR_CHANNEL_COUNT - 1] = MOTOR_MS_PER_ML_Q16(PUMP_FLOW_CML_PER_S)
+};
+
+//채널별 투여 프로파일 (레지스터로 설정, 기본값: 최대 속도, 마무리 구간 없음)
+uint8_t g_motor_profiles[MOTOR_CHANNEL_COUNT][MOTOR_PROFILE_SIZE] = {
+	[0 ... MOTOR_CHANNEL_COUNT - 1] = { 255, 0, 0 }
+};
+
+//채널별 남은 투여 시간 (tick 단위, 0이면 정지 상태)
+static volatile uint32_t dose_remaining_ticks[MOTOR_CHANNEL_COUNT];
+
+#if MOTOR_USE_PWM
+//채널별 출력: Timer0 비교 레지스터와 출력 연결 비트 (OC0A: PD6, OC0B: PD5)
+static volatile uint8_t * const motor_ocr[MOTOR_CHANNEL_COUNT] = { &OCR0A, &OCR0B };
+static const uint8_t motor_com_bits[MOTOR_CHANNEL_COUNT] = { (1<<COM0A1), (1<<COM0B1) };
+
+//본 구간이 끝난 뒤 이어질 마무리 구간 (tick 단위, 0이면 없음)과 그 속도
+static volatile uint32_t dose_tail_ticks[MOTOR_CHANNEL_COUNT];
+static uint8_t dose_tail_duty[MOTOR_CHANNEL_COUNT];
+#else
+//채널별 출력 핀 (모두 MOTOR_PORT)
+static const uint8_t motor_pin_bits[MOTOR_CHANNEL_COUNT] = { PIN8_BIT, PIN9_BIT };
+#endif
+
+#if MOTOR_USE_FLOW_SENSOR
+//채널별 센서 입력 핀 (모두 FLOW_SENSOR_PIN)
+static const uint8_t flow_sensor_bits[MOTOR_CHANNEL_COUNT] = { FLOW_SENSOR0_BIT, FLOW_SENSOR1_BIT };
+static uint8_t flow_last_pins;
+
+//남은 펄스 수 (0이면 펄스 무시), 마무리 구간 속도로 바꿀 남은 펄스 수 (PWM)
+static volatile uint32_t dose_remaining_pulses[MOTOR_CHANNEL_COUNT];
+#if MOTOR_USE_PWM
+static uint32_t dose_tail_pulses[MOTOR_CHANNEL_COUNT];
+#endif
+
+//보정용 측정: 현재 출력 duty와 투여 중 tick마다 누적한 duty (255 = 최대 속도 1ms)
+static volatile uint8_t dose_duty[MOTOR_CHANNEL_COUNT];
+static volatile uint32_t dose_duty_ticks[MOTOR_CHANNEL_COUNT];
+static volatile uint16_t dose_volume[MOTOR_CHANNEL_COUNT];	//측정 중인 투여량 (mL)
+static volatile uint8_t dose_measured[MOTOR_CHANNEL_COUNT];	//펄스로 끝나 보정 반영을 기다림
+static volatile uint8_t dose_faults[MOTOR_CHANNEL_COUNT];
+#endif
 
 void motor_init(){
+#if MOTOR_USE_PWM
+	//출력은 PORT 0 (PWM 연결이 끊기면 Low), Fast PWM (TOP 0xFF), PWM 주기마다 CPU 개입 없음
+	PIN6_PORT &= ~PIN6_BIT;
+	PIN5_PORT &= ~PIN5_BIT;
+	PIN6_DDR |= PIN6_BIT;
+	PIN5_DDR |= PIN5_BIT;
+	TCCR0A = (1<<WGM01) | (1<<WGM00);
+	TCCR0B = MOTOR_PWM_PRESCALER_BITS;
+#else
 	PIN8_DDR |=PIN8_BIT;
 	PIN9_DDR |= PIN9_BIT;
+#endif
+#if MOTOR_USE_FLOW_SENSOR
+	//센서 입력 (오픈 컬렉터 출력이므로 풀업), 두 핀의 변화를 PCINT1 인터럽트 하나로 받음
+	FLOW_SENSOR_DDR &= ~(FLOW_SENSOR0_BIT | FLOW_SENSOR1_BIT);
+	FLOW_SENSOR_PORT |= FLOW_SENSOR0_BIT | FLOW_SENSOR1_BIT;
+	flow_last_pins = FLOW_SENSOR_PIN;
+	PCMSK1 |= FLOW_SENSOR_PCINT_BITS;
+	PCICR |= (1<<PCIE1);
+#endif
+}
+
+//채널 출력을 duty(0이면 정지)로 설정. 호출자가 임계 구역 또는 ISR 문맥에서 호출
+static inline void motor_output(uint8_t channel, uint8_t duty){
+#if MOTOR_USE_FLOW_SENSOR
+	dose_duty[channel] = duty;
+#endif
+#if MOTOR_USE_PWM
+	if (duty != 0) {
+		*motor_ocr[channel] = duty; //다음 PWM 주기 시작부터 적용 (하드웨어 이중 버퍼)
+		TCCR0A |= motor_com_bits[channel];
+	} else {
+		TCCR0A &= ~motor_com_bits[channel]; //PWM 연결 해제 -> 핀은 PORT 값(0)
+	}
+#else
+	if (duty != 0) {
+		MOTOR_PORT |= motor_pin_bits[channel];
+	} else {
+		MOTOR_PORT &= ~motor_pin_bits[channel];
+	}
+#endif
 }
 //모터 동작시키는 기능
+//스케줄러 시작 전에 호출되어도 블록하지 않으며, 정지는 tick 인터럽트가 처리
 void motor_W1(){
-   float target = 100;
-   float flow_time = (target/Pump_Flow) * 1000;
-   
-   PORTB |= (1<<PB0); 
-   delay(flow_time);
-   PORTB &= ~(1<<PB0);
-}
\ No newline at end of file
+   motor_dose_volume(0, 100);
+}
+
+//Q16.16 곱셈을 정수부/소수부로 나누어 32비트 연산만 사용 (64비트/부동소수점 라이브러리 불필요)
+static uint32_t motor_q16_mul(uint32_t q16, uint16_t n){
+   uint32_t whole = q16 >> 16;
+   uint32_t fract = q16 & 0xFFFF;
+
+   return (uint32_t)n * whole + (((uint32_t)n * fract + 0x8000) >> 16);
+}
+
+uint32_t motor_volume_to_ms(uint8_t channel, uint16_t volume_ml){
+   return motor_q16_mul(motor_ms_per_ml_q16[channel], volume_ml);
+}
+
+#if MOTOR_USE_FLOW_SENSOR
+//펄스로 끝난 투여의 측정 유량을 보정값에 반영 (Task 문맥, 나눗셈은 ISR 밖에서)
+static void motor_apply_measurement(uint8_t channel){
+	uint8_t measured;
+	uint16_t volume;
+	uint32_t duty_ticks, per_ml, measured_q16, current;
+
+	taskENTER_CRITICAL();
+	measured = dose_measured[channel];
+	dose_measured[channel] = 0;
+	duty_ticks = dose_duty_ticks[channel];
+	volume = dose_volume[channel];
+	taskEXIT_CRITICAL();
+
+	if (!measured || volume == 0) {
+		return;
+	}
+
+	//최대 속도 환산 1mL당 시간 = duty_ticks / 255 / volume (ms), Q16.16에서 65536 / 255 ~= 257
+	per_ml = duty_ticks / volume;
+	measured_q16 = per_ml * 257 + (duty_ticks % volume) * 257 / volume;
+
+	//센서 이상으로 보이는 측정값은 현재 보정값의 1/2 ~ 2배로 제한한 뒤 조금씩 반영
+	//32비트 보정값의 읽기-수정-쓰기는 인터럽트를 막고 한 번에 (나눗셈 없이 비교/시프트만)
+	taskENTER_CRITICAL();
+	current = motor_ms_per_ml_q16[channel];
+	if (measured_q16 > current * 2) {
+		measured_q16 = current * 2;
+	} else if (measured_q16 < current / 2) {
+		measured_q16 = current / 2;
+	}
+	if (measured_q16 >= current) {
+		current += (measured_q16 - current) >> FLOW_CALIBRATION_SHIFT;
+	} else {
+		current -= (current - measured_q16) >> FLOW_CALIBRATION_SHIFT;
+	}
+	motor_ms_per_ml_q16[channel] = current;
+	taskEXIT_CRITICAL();
+}
+
+//투여량을 센서 펄스 수로 변환 (반올림, 최소 1)
+static uint32_t motor_tenths_to_pulses(uint32_t volume_tenths){
+	uint32_t pulses = (volume_tenths * FLOW_SENSOR_PULSES_PER_L + 5000) / 10000;
+
+	return pulses ? pulses : 1;
+}
+#endif
+
+uint32_t motor_calibration_q16(uint8_t channel){
+	if (channel >= MOTOR_CHANNEL_COUNT) {
+		return 0;
+	}
+#if MOTOR_USE_FLOW_SENSOR
+	motor_apply_measurement(channel);
+#endif
+	return motor_ms_per_ml_q16[channel];
+}
+
+uint8_t motor_flow_faults(uint8_t channel){
+#if MOTOR_USE_FLOW_SENSOR
+	if (channel < MOTOR_CHANNEL_COUNT) {
+		return dose_faults[channel];
+	}
+#else
+	(void)channel;
+#endif
+	return 0;
+}
+
+//본 구간 bulk_ms를 bulk_duty로, 이어서 마무리 구간 tail_ms를 tail_duty로 구동하도록 예약
+static uint8_t motor_dose_begin(uint8_t channel, uint32_t bulk_ms, uint8_t bulk_duty, uint32_t tail_ms, uint8_t tail_duty){
+	uint32_t ticks = bulk_ms / portTICK_PERIOD_MS;
+	uint32_t tail_ticks = tail_ms / portTICK_PERIOD_MS;
+
+	if (channel >= MOTOR_CHANNEL_COUNT) {
+		return 0;
+	}
+	if (ticks == 0) { //본 구간이 없으면 마무리 구간부터
+		ticks = tail_ticks;
+		bulk_duty = tail_duty;
+		tail_ticks = 0;
+	}
+	if (ticks == 0) {
+		motor_dose_stop(channel);
+		return 1;
+	}
+
+	//tick 인터럽트와 겹치지 않도록 남은 시간과 출력을 함께 갱신
+	taskENTER_CRITICAL();
+	dose_remaining_ticks[channel] = ticks;
+#if MOTOR_USE_FLOW_SENSOR
+	dose_remaining_pulses[channel] = 0; //펄스 목표는 motor_dose_volume()이 이어서 설정
+	dose_measured[channel] = 0;
+	dose_duty_ticks[channel] = 0;
+#endif
+#if MOTOR_USE_PWM
+	dose_tail_ticks[channel] = tail_ticks;
+	dose_tail_duty[channel] = tail_duty;
+#else
+	(void)tail_ticks;
+#endif
+	motor_output(channel, bulk_duty);
+	taskEXIT_CRITICAL();
+	return 1;
+}
+
+uint8_t motor_dose_start(uint8_t channel, uint32_t duration_ms){
+	return motor_dose_begin(channel, duration_ms, 255, 0, 0);
+}
+
+#if MOTOR_USE_PWM
+//최대 속도 기준 구동 시간을 duty 속도 기준으로 늘림 (유량이 duty에 비례한다고 봄)
+static uint32_t motor_scale_to_duty(uint32_t full_speed_ms, uint8_t duty){
+	return (full_speed_ms * 255 + duty / 2) / duty;
+}
+#endif
+
+uint8_t motor_dose_volume(uint8_t channel, uint16_t volume_ml){
+	uint8_t bulk_duty = 255, tail_duty = 0;
+	uint16_t tail_tenths = 0;
+	uint32_t total_ms, bulk_ms, tail_ms = 0;
+#if MOTOR_USE_PWM
+	const uint8_t *profile;
+#endif
+#if MOTOR_USE_FLOW_SENSOR
+	uint8_t started;
+	uint32_t pulses, tail_pulses;
+#endif
+
+	if (channel >= MOTOR_CHANNEL_COUNT) {
+		return 0;
+	}
+#if MOTOR_USE_FLOW_SENSOR
+	motor_apply_measurement(channel);
+#endif
+	total_ms = motor_volume_to_ms(channel, volume_ml);
+	bulk_ms = total_ms;
+
+#if MOTOR_USE_PWM
+	profile = g_motor_profiles[channel];
+	bulk_duty = profile[MOTOR_PROFILE_BULK_DUTY] ? profile[MOTOR_PROFILE_BULK_DUTY] : 255;
+	tail_duty = profile[MOTOR_PROFILE_TAIL_DUTY];
+	tail_tenths = tail_duty ? profile[MOTOR_PROFILE_TAIL_VOLUME] : 0;
+	if (tail_tenths > volume_ml * 10) { //투여량 전체가 마무리 구간
+		tail_tenths = volume_ml * 10;
+	}
+
+	//0.1mL당 구동 시간 = 1mL당 시간 / 10
+	tail_ms = motor_q16_mul((motor_ms_per_ml_q16[channel] + 5) / 10, tail_tenths);
+	if (tail_ms > total_ms) {
+		tail_ms = total_ms;
+	}
+	bulk_ms = motor_scale_to_duty(total_ms - tail_ms, bulk_duty);
+	tail_ms = tail_tenths ? motor_scale_to_duty(tail_ms, tail_duty) : 0;
+#else
+	//On/Off 출력은 속도를 바꿀 수 없으므로 프로파일 없이 최대 속도
+	(void)tail_tenths;
+#endif
+
+#if MOTOR_USE_FLOW_SENSOR
+	if (volume_ml == 0) {
+		motor_dose_stop(channel);
+		return 1;
+	}
+
+	//끝과 속도 전환은 펄스 인터럽트가 정하고, 구동 시간은 센서 이상에 대비한 제한 시간으로만 사용
+	pulses = motor_tenths_to_pulses((uint32_t)volume_ml * 10);
+	tail_pulses = tail_tenths ? motor_tenths_to_pulses(tail_tenths) : 0;
+	if (tail_pulses >= pulses) { //투여량 전체가 마무리 구간
+		bulk_duty = tail_duty;
+		tail_pulses = 0;
+	}
+
+	taskENTER_CRITICAL();
+	started = motor_dose_begin(channel, (bulk_ms + tail_ms) * FLOW_TIMEOUT_FACTOR + 1, bulk_duty, 0, 0);
+	dose_remaining_pulses[channel] = pulses;
+#if MOTOR_USE_PWM
+	dose_tail_pulses[channel] = tail_pulses;
+	dose_tail_duty[channel] = tail_duty;
+#endif
+	dose_volume[channel] = volume_ml;
+	taskEXIT_CRITICAL();
+	return started;
+#else
+	return motor_dose_begin(channel, bulk_ms, bulk_duty, tail_ms, tail_duty);
+#endif
+}
+
+void motor_dose_stop(uint8_t channel){
+	if (channel >= MOTOR_CHANNEL_COUNT) {
+		return;
+	}
+
+	taskENTER_CRITICAL();
+	dose_remaining_ticks[channel] = 0;
+#if MOTOR_USE_PWM
+	dose_tail_ticks[channel] = 0;
+#endif
+#if MOTOR_USE_FLOW_SENSOR
+	dose_remaining_pulses[channel] = 0;
+#endif
+	motor_output(channel, 0);
+	taskEXIT_CRITICAL();
+}
+
+uint8_t motor_dose_is_active(uint8_t channel){
+	uint8_t active;
+
+	if (channel >= MOTOR_CHANNEL_COUNT) {
+		return 0;
+	}
+
+	taskENTER_CRITICAL();
+	active = (dose_remaining_ticks[channel] != 0);
+	taskEXIT_CRITICAL();
+	return active;
+}
+
+//tick ISR 문맥에서 실행되므로 짧게 유지 (채널당 32비트 감소 1회, 유량 센서가 있으면 32비트 덧셈 1회 추가)
+//구간이 바뀔 때만 비교 레지스터를 한 번 쓰고, PWM 파형 자체는 Timer0이 만듦
+//유량 센서가 있으면 남은 시간은 제한 시간이며, 다 되도록 펄스가 모자라면 중단하고 고장으로 셈
+void motor_dose_tick(void){
+	for (uint8_t channel = 0; channel < MOTOR_CHANNEL_COUNT; channel++) {
+		uint32_t remaining = dose_remaining_ticks[channel];
+
+		if (remaining == 0) {
+			continue;
+		}
+		if (--remaining == 0) {
+#if MOTOR_USE_PWM
+			if (dose_tail_ticks[channel] != 0) { //본 구간 끝 -> 마무리 구간 속도로
+				remaining = dose_tail_ticks[channel];
+				dose_tail_ticks[channel] = 0;
+				motor_output(channel, dose_tail_duty[channel]);
+			} else {
+				motor_output(channel, 0);
+			}
+#else
+			motor_output(channel, 0);
+#endif
+		}
+		dose_remaining_ticks[channel] = remaining;
+#if MOTOR_USE_FLOW_SENSOR
+		dose_duty_ticks[channel] += dose_duty[channel];
+		if (remaining == 0 && dose_remaining_pulses[channel] != 0) {
+			dose_remaining_pulses[channel] = 0;
+			if (dose_faults[channel] != 0xFF) {
+				dose_faults[channel]++;
+			}
+		}
+#endif
+	}
+}
+
+#if MOTOR_USE_FLOW_SENSOR
+//유량 센서 펄스 (PC0/PC1 핀 변화, 상승 에지만 셈)
+//펄스마다 Task를 깨우지 않고 ISR 안에서 세며, 목표 펄스에 닿는 즉시 펌프를 끔
+//보정값 계산(나눗셈)은 다음 투여 때 Task 문맥에서 함
+ISR(PCINT1_vect){
+	uint8_t pins = FLOW_SENSOR_PIN;
+	uint8_t rising = pins & ~flow_last_pins;
+
+	flow_last_pins = pins;
+	for (uint8_t channel = 0; channel < MOTOR_CHANNEL_COUNT; channel++) {
+		uint32_t remaining;
+
+		if (!(rising & flow_sensor_bits[channel])) {
+			continue;
+		}
+		remaining = dose_remaining_pulses[channel];
+		if (remaining == 0) { //투여 중이 아니거나 시간 기준 투여
+			continue;
+		}
+		if (--remaining == 0) {
+			motor_output(channel, 0);
+			dose_remaining_ticks[channel] = 0;
+			dose_measured[channel] = 1;
+		}
+#if MOTOR_USE_PWM
+		else if (remaining == dose_tail_pulses[channel]) { //본 구간 끝 -> 마무리 구간 속도로
+			motor_output(channel, dose_tail_duty[channel]);
+		}
+#endif
+		dose_remaining_pulses[channel] = remaining;
+	}
+}
+#endif
\ No newline at end of file
@@ -1,6 +1,13 @@
 ﻿
+#ifndef MOTOR_H_
+#define MOTOR_H_
+
 #include <avr/io.h>
 
+#ifndef MOTOR_USE_PWM
+#define MOTOR_USE_PWM 0 // 1: Timer0 하드웨어 PWM 속도 제어 + 투여 프로파일 (채널 0: PD6/OC0A, 채널 1: PD5/OC0B), 0: PB0/PB1 On/Off (기존 배선)
+#endif
+
 #define PIN8_PORT PORTB
 #define PIN8_DDR DDRB
 #define PIN8_BIT (1<<PB0)
@@ -9,8 +16,97 @@
 #define PIN9_DDR DDRB
 #define PIN9_BIT (1<<PB1)
 
+#define PIN6_PORT PORTD
+#define PIN6_DDR DDRD
+#define PIN6_BIT (1<<PD6)
+
+#define PIN5_PORT PORTD
+#define PIN5_DDR DDRD
+#define PIN5_BIT (1<<PD5)
+
+#ifndef MOTOR_USE_FLOW_SENSOR
+#define MOTOR_USE_FLOW_SENSOR 0 // 1: 유량 센서 펄스 수로 투여를 끝내고 유량 보정값을 자동 갱신 (채널 0: PC0, 1: PC1), 0: 구동 시간으로 투여 (기존 방식)
+#endif
+
+// 유량 센서(홀 센서 펄스) 입력: 핀 변화 인터럽트 PCINT1 그룹, 내부 풀업 사용
+// INT0/INT1(PD2/PD3)은 RS-485 RE/DE, ICP1(PB0)은 펌프 출력이고 Timer1은 tick이라 쓸 수 없음
+#define FLOW_SENSOR_PIN PINC
+#define FLOW_SENSOR_PORT PORTC
+#define FLOW_SENSOR_DDR DDRC
+#define FLOW_SENSOR0_BIT (1<<PC0)
+#define FLOW_SENSOR1_BIT (1<<PC1)
+#define FLOW_SENSOR_PCINT_BITS ((1<<PCINT8) | (1<<PCINT9))
+
+// 센서 상수 (1L당 펄스 수, 센서 데이터시트 값)
+#define FLOW_SENSOR_PULSES_PER_L 5880
+
+// 펄스가 예상 구동 시간의 몇 배 안에 모두 들어오지 않으면 투여를 중단 (센서 단선, 공회전, 막힘)
+#define FLOW_TIMEOUT_FACTOR 2
+
+// 투여가 끝날 때마다 측정한 유량을 보정값에 1/2^SHIFT만큼 반영 (한 번의 튀는 측정값에 휘둘리지 않음)
+#define FLOW_CALIBRATION_SHIFT 2
+
+// 동시에 투여(dose)할 수 있는 펌프 채널 수 (0: PB0, 1: PB1 / PWM이면 0: PD6, 1: PD5)
+#if MOTOR_USE_PWM
+#define MOTOR_PORT PORTD
+#else
+#define MOTOR_PORT PORTB
+#endif
+#define MOTOR_CHANNEL_COUNT 2
+
+// PWM 주파수: 16MHz / 8분주 / 256 = 7.8kHz (Timer0 Fast PWM, duty 255 = 항상 On)
+#define MOTOR_PWM_PRESCALER_BITS (1<<CS01)
+
+// 투여 프로파일 (채널마다 MOTOR_PROFILE_SIZE 바이트, 프로토콜 레지스터로 읽기/쓰기, MOTOR_USE_PWM일 때만 사용)
+// 투여량의 마지막 TAIL_VOLUME은 TAIL_DUTY 속도로, 나머지는 BULK_DUTY 속도로 보냅니다.
+// 유량은 duty에 비례한다고 보고 각 구간의 시간을 255 / duty배로 늘립니다.
+#define MOTOR_PROFILE_BULK_DUTY   0 // 본 구간 속도 (1~255, 0이면 255)
+#define MOTOR_PROFILE_TAIL_DUTY   1 // 마무리 구간 속도 (1~255, 0이면 마무리 구간 없음)
+#define MOTOR_PROFILE_TAIL_VOLUME 2 // 마무리 구간 투여량 (0.1mL 단위)
+#define MOTOR_PROFILE_SIZE        3
+
+extern uint8_t g_motor_profiles[MOTOR_CHANNEL_COUNT][MOTOR_PROFILE_SIZE];
+
+// 펌프 유량 보정값 (0.01mL/s 단위 정수, 357 = 3.57mL/s)
+#define PUMP_FLOW_CML_PER_S 357
+
+// 유량(0.01mL/s) -> 1mL당 구동 시간(ms, Q16.16 고정소수점)
+// 컴파일 시간에 계산되므로 64비트 상수 연산이 코드에 남지 않음
+#define MOTOR_MS_PER_ML_Q16(flow_cml_per_s) \
+	((uint32_t)((100000ULL * 65536ULL + (flow_cml_per_s) / 2) / (flow_cml_per_s)))
+
 //모터 초기화 함수
 void motor_init();
 
-//첫번째 유량모터 구동시키는 함수
+//첫번째 유량모터 구동시키는 함수 (100mL 투여 시작, 블록하지 않음)
 void motor_W1();
+
+//채널의 보정값으로 투여량(mL)을 최대 속도 구동 시간(ms)으로 변환
+uint32_t motor_volume_to_ms(uint8_t channel, uint16_t volume_ml);
+
+//채널의 유량 보정값 (최대 속도에서 1mL당 구동 시간, ms Q16.16)
+//MOTOR_USE_FLOW_SENSOR이면 끝난 투여의 측정값을 먼저 반영
+uint32_t motor_calibration_q16(uint8_t channel);
+
+//펄스가 제한 시간 안에 다 들어오지 않아 중단된 투여 횟수 (255에서 멈춤, MOTOR_USE_FLOW_SENSOR)
+uint8_t motor_flow_faults(uint8_t channel);
+
+//펌프를 최대 속도로 켜고 duration_ms 후 tick 인터럽트에서 끄도록 예약 (즉시 반환)
+//duration_ms가 0이면 해당 채널을 멈춤. 잘못된 채널이면 0 반환
+uint8_t motor_dose_start(uint8_t channel, uint32_t duration_ms);
+
+//채널의 투여 프로파일로 volume_ml 투여를 예약 (즉시 반환, 속도 전환도 tick 인터럽트가 처리)
+//MOTOR_USE_FLOW_SENSOR이면 센서 펄스 인터럽트가 목표 펄스 수에서 펌프를 끄고 속도도 전환
+//volume_ml이 0이면 해당 채널을 멈춤. 잘못된 채널이면 0 반환
+uint8_t motor_dose_volume(uint8_t channel, uint16_t volume_ml);
+
+//진행 중인 투여를 즉시 중단
+void motor_dose_stop(uint8_t channel);
+
+//채널이 투여 중이면 1 반환
+uint8_t motor_dose_is_active(uint8_t channel);
+
+//FreeRTOS tick 훅에서 매 tick 호출: 남은 시간을 줄이고 완료된 펌프를 끔
+void motor_dose_tick(void);
+
+#endif /* MOTOR_H_ */
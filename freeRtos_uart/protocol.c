@@ -6,12 +6,62 @@
  */ 
 
 #include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
 
 #include "uart.h"
+#include "motor.h"
+#include "crc16.h"
+#include "task_stats.h"
+#include "dose_queue.h"
 #include "protocol.h"
 
 // 가상의 데이터 저장소 (Address 0x00 ~ 0x0F)
-uint8_t g_device_registers[16] = {0};
+uint8_t g_device_registers[DEVICE_REGISTER_COUNT] = {0};
+
+// 통신 카운터 (상태 레지스터 0x80~)
+volatile uint16_t g_comm_stats[COMM_STAT_COUNT];
+
+// 태스크 상태 (상태 레지스터 TASK_STAT_REGISTER_BASE~, task_stats_update()가 갱신)
+uint16_t g_task_stats[TASK_STAT_COUNT];
+
+// 명령 처리 함수: 길이/체크섬 검사를 통과한 전체 프레임과 그 길이를 받습니다.
+typedef void (*command_handler_t)(uint8_t *buffer, uint8_t length);
+
+// 명령 디스패치 테이블 항목 (Flash에 저장)
+typedef struct {
+	uint8_t frame_length;		// 전체 프레임 길이 ('$'...'\n' 포함), 0이면 정의되지 않은 명령
+								// FRAME_LENGTH_VARIABLE이면 길이 검사는 처리 함수가 담당
+	uint8_t checksum_span;		// 체크섬 계산에 포함될 바이트 수 (ID부터, 가변 길이면 Checksum 앞까지 전체)
+	command_handler_t handler;
+} command_entry_t;
+
+static void handle_write(uint8_t *buffer, uint8_t length);
+static void handle_read(uint8_t *buffer, uint8_t length);
+static void handle_dose(uint8_t *buffer, uint8_t length);
+static void handle_bulk_read(uint8_t *buffer, uint8_t length);
+static void handle_bulk_write(uint8_t *buffer, uint8_t length);
+static void handle_baud(uint8_t *buffer, uint8_t length);
+static void handle_queue(uint8_t *buffer, uint8_t length);
+
+// 명령 바이트로 바로 인덱싱되는 디스패치 테이블
+// 새 명령은 항목 한 줄만 추가하면 되며, 처리 경로에 분기가 늘지 않습니다.
+#define COMMAND_ENTRY(cmd)	[(cmd) - PROTOCOL_CMD_FIRST]
+
+static const command_entry_t command_table[PROTOCOL_CMD_COUNT] PROGMEM = {
+	COMMAND_ENTRY('W') = { FRAME_LENGTH(4), 4, handle_write },		// ID, Cmd, Addr, Data
+	COMMAND_ENTRY('R') = { FRAME_LENGTH(3), 3, handle_read },		// ID, Cmd, Addr
+	COMMAND_ENTRY('D') = { FRAME_LENGTH(4), 4, handle_dose },		// ID, Cmd, Channel, Volume
+	COMMAND_ENTRY('r') = { FRAME_LENGTH(4), 4, handle_bulk_read },	// ID, Cmd, Start, Count
+	COMMAND_ENTRY('w') = { FRAME_LENGTH_VARIABLE, 0, handle_bulk_write },	// ID, Cmd, Start, Count, Data[Count]
+	COMMAND_ENTRY('B') = { FRAME_LENGTH(3), 3, handle_baud },		// ID, Cmd, BaudCode
+	COMMAND_ENTRY('Q') = { FRAME_LENGTH_VARIABLE, 0, handle_queue },	// ID, Cmd, Count, Job[Count]
+};
+
+// 'B' 명령의 보율코드 -> 보율
+static const uint32_t baud_table[PROTOCOL_BAUD_CODE_COUNT] PROGMEM = {
+	9600, 57600, 115200, 250000, 500000, 1000000
+};
 
 /**
  * @brief PDF 프로토콜에 정의된 체크섬을 계산합니다. 
@@ -29,6 +79,115 @@ uint8_t calculate_checksum(uint8_t *buffer, uint8_t length) {
 
 
 
+/**
+ * @brief 앞부분만 받은 프레임의 전체 길이를 디스패치 테이블로 구합니다 (가변 길이 명령은 Count 바이트로).
+ * frame.c가 PROTOCOL_USE_ESCAPE = 0 에서 '$'가 데이터 자리인지 판단할 때와 가변 길이 명령의 길이 검사에 사용합니다.
+ * @param frame 받은 프레임 ('$'부터)
+ * @param received 받은 바이트 수
+ * @return 전체 길이 ('$'...'\n' 포함), 길이를 정하는 바이트가 아직 없으면 FRAME_LENGTH_UNKNOWN,
+ *         알 수 없는 명령이나 너무 큰 Count면 FRAME_LENGTH_INVALID
+ */
+uint8_t protocol_frame_length(const uint8_t *frame, uint8_t received) {
+	uint8_t index;
+	uint8_t length;
+	uint8_t count;
+
+	if (received <= FRAME_IDX_CMD) {
+		return FRAME_LENGTH_UNKNOWN;
+	}
+	index = (uint8_t)(frame[FRAME_IDX_CMD] - PROTOCOL_CMD_FIRST);
+	if (index >= PROTOCOL_CMD_COUNT) {
+		return FRAME_LENGTH_INVALID;
+	}
+	length = pgm_read_byte(&command_table[index].frame_length);
+	if (length == 0) {
+		return FRAME_LENGTH_INVALID;
+	}
+	if (length != FRAME_LENGTH_VARIABLE) {
+		return length;
+	}
+
+	switch (frame[FRAME_IDX_CMD]) {
+	case 'w': // ID, Cmd, Start, Count, Data[Count]
+		if (received <= FRAME_IDX_BULK_COUNT) {
+			return FRAME_LENGTH_UNKNOWN;
+		}
+		count = frame[FRAME_IDX_BULK_COUNT];
+		if (count > PROTOCOL_MAX_BULK) {
+			return FRAME_LENGTH_INVALID;
+		}
+		return FRAME_LENGTH(FRAME_IDX_BULK_DATA - 1 + count);
+	case 'Q': // ID, Cmd, Count, Job[Count]
+		if (received <= FRAME_IDX_Q_COUNT) {
+			return FRAME_LENGTH_UNKNOWN;
+		}
+		count = frame[FRAME_IDX_Q_COUNT];
+		if (count > PROTOCOL_MAX_QUEUE_JOBS) {
+			return FRAME_LENGTH_INVALID;
+		}
+		return FRAME_LENGTH(FRAME_IDX_Q_JOBS - 1 + count * DOSE_JOB_SIZE);
+	}
+	return FRAME_LENGTH_INVALID;
+}
+
+/**
+ * @brief 프레임의 '$', 체크섬(또는 CRC-16), '\n'을 채웁니다.
+ * @param frame 프레임 버퍼 (frame[1]부터 payload_length 바이트가 채워져 있어야 함)
+ * @param payload_length ID부터 Checksum 앞까지의 바이트 수
+ * @return 완성된 프레임의 전체 길이
+ */
+uint8_t protocol_finish_frame(uint8_t *frame, uint8_t payload_length) {
+	uint8_t *checksum = &frame[payload_length + 1];
+
+	frame[0] = '$';
+#if PROTOCOL_USE_CRC16
+	// CRC-16/MODBUS: ID부터 데이터까지, 하위 바이트 먼저
+	uint16_t crc = crc16_calculate(&frame[1], payload_length);
+	checksum[0] = (uint8_t)crc;
+	checksum[1] = (uint8_t)(crc >> 8);
+#else
+	// 체크섬 계산: ID부터 데이터까지의 합
+	checksum[0] = calculate_checksum(&frame[1], payload_length);
+#endif
+	checksum[FRAME_CHECKSUM_SIZE] = '\n';
+	return FRAME_LENGTH(payload_length);
+}
+
+#if PROTOCOL_USE_ESCAPE
+// 이스케이프된 송신 프레임 (최악의 경우 '$', '\n'을 뺀 모든 바이트가 2바이트로)
+static uint8_t tx_wire[2 * PROTOCOL_BUFFER_SIZE];
+#endif
+
+/**
+ * @brief 프레임을 완성하고 전송합니다.
+ * @param frame 전송할 프레임 (frame[1]부터 payload_length 바이트가 채워져 있어야 함)
+ * @param payload_length ID부터 Checksum 앞까지의 바이트 수
+ */
+static void send_frame(uint8_t *frame, uint8_t payload_length) {
+	uint8_t length = protocol_finish_frame(frame, payload_length);
+
+	// uart_tx_frame 함수는 RS-485 송신 모드를 자동으로 처리합니다 (프레임당 한 번).
+#if PROTOCOL_USE_ESCAPE
+	// '$'와 '\n' 사이의 구분자/ESC 바이트는 ESC, (값 ^ 0x20)으로 보냄
+	uint8_t wire_length = 0;
+
+	tx_wire[wire_length++] = '$';
+	for (uint8_t i = 1; i < length - 1; i++) {
+		uint8_t data = frame[i];
+		if (FRAME_NEEDS_ESCAPE(data)) {
+			tx_wire[wire_length++] = FRAME_ESCAPE;
+			data ^= FRAME_ESCAPE_XOR;
+		}
+		tx_wire[wire_length++] = data;
+	}
+	tx_wire[wire_length++] = '\n';
+	uart_tx_frame(tx_wire, wire_length);
+#else
+	uart_tx_frame(frame, length);
+#endif
+	COMM_STAT_INC(COMM_STAT_SERVED);
+}
+
 /**
  * @brief Master에게 보낼 응답 프레임을 생성하고 전송합니다. 
  * @param slave_id 응답하는 Slave ID
@@ -37,90 +196,320 @@ uint8_t calculate_checksum(uint8_t *buffer, uint8_t length) {
  * @param data 'R' 명령의 경우 읽은 값, 'W' 명령의 경우 쓴 값
  */
 void send_response(uint8_t slave_id, uint8_t cmd, uint8_t addr, uint8_t data) {
-	uint8_t response[7]; // 응답 프레임 (7바이트 고정)
-	uint8_t checksum;
+	uint8_t response[FRAME_LENGTH(4)]; // 응답 프레임 (고정 길이)
 
-	response[0] = '$';
 	response[1] = slave_id;
 	response[2] = cmd;
 	response[3] = addr;
 	response[4] = data; // R 응답 시 읽은 데이터
-	
-	// 체크섬 계산: ID부터 데이터까지의 합
-	checksum = calculate_checksum(&response[1], 4);
-	
-	response[5] = checksum;
-	response[6] = '\n';
 
-	// uart_tx 함수는 RS-485 송신 모드를 자동으로 처리합니다.
-	for (uint8_t i = 0; i < 7; i++) {
-		uart_tx(response[i]);
+	send_frame(response, 4);
+}
+
+/**
+ * @brief 레지스터 범위 [start, start + count)를 start가 속한 영역의 끝(end)에 맞게 자릅니다.
+ * @return 처리 가능한 레지스터 수 (end가 0이면, 즉 start가 영역 밖이면 0)
+ */
+static uint8_t clip_to_region(uint8_t start, uint8_t count, uint8_t end) {
+	if (end == 0) {
+		return 0;
+	}
+	if (count > end - start) {
+		count = end - start;
+	}
+	return count;
+}
+
+/**
+ * @brief start가 속한 쓰기 가능 영역(가상 레지스터, 투여 프로파일)의 끝 주소를 반환합니다.
+ * @return 영역 끝 (다음 주소), start가 쓰기 가능 영역 밖이면 0
+ */
+static uint8_t writable_region_end(uint8_t start) {
+	if (start < DEVICE_REGISTER_COUNT) {
+		return DEVICE_REGISTER_COUNT;
+	}
+	if (start >= MOTOR_REGISTER_BASE && start < MOTOR_REGISTER_BASE + MOTOR_REGISTER_COUNT) {
+		return MOTOR_REGISTER_BASE + MOTOR_REGISTER_COUNT;
+	}
+	return 0;
+}
+
+/**
+ * @brief 쓰기 범위를 start가 속한 쓰기 가능 영역 안으로 자릅니다.
+ * @return 처리 가능한 레지스터 수 (start가 범위 밖이면 0)
+ */
+static uint8_t clip_register_count(uint8_t start, uint8_t count) {
+	return clip_to_region(start, count, writable_region_end(start));
+}
+
+/**
+ * @brief 읽기 범위를 자릅니다: 최대 PROTOCOL_MAX_BULK개, start가 속한 영역(쓰기 가능 영역 또는 상태 레지스터) 안으로.
+ * @return 읽을 수 있는 레지스터 수 (start가 모든 영역 밖이면 0)
+ */
+static uint8_t clip_read_count(uint8_t start, uint8_t count) {
+	if (count > PROTOCOL_MAX_BULK) { // 응답 프레임 버퍼 크기
+		count = PROTOCOL_MAX_BULK;
+	}
+	if (start >= STATUS_REGISTER_BASE && start < STATUS_REGISTER_BASE + STATUS_REGISTER_COUNT) {
+		return clip_to_region(start, count, STATUS_REGISTER_BASE + STATUS_REGISTER_COUNT);
+	}
+	return clip_register_count(start, count);
+}
+
+/**
+ * @brief 쓰기 가능한 레지스터 1바이트를 씁니다 (그 외 주소는 무시).
+ */
+static void write_register(uint8_t addr, uint8_t data) {
+	if (addr < DEVICE_REGISTER_COUNT) {
+		g_device_registers[addr] = data;
+	} else if (addr >= MOTOR_REGISTER_BASE && addr < MOTOR_REGISTER_BASE + MOTOR_REGISTER_COUNT) {
+		((uint8_t *)g_motor_profiles)[addr - MOTOR_REGISTER_BASE] = data; // 채널 순서로 연속 배치
+	}
+}
+
+/**
+ * @brief 레지스터 1바이트를 읽습니다 (가상 레지스터, 투여 프로파일, 상태 레지스터, 그 외는 0).
+ * 상태 레지스터는 ISR이 갱신하므로 호출자가 인터럽트를 막은 상태에서 불러야 합니다.
+ */
+static uint8_t read_register(uint8_t addr) {
+	uint16_t value;
+
+	if (addr < DEVICE_REGISTER_COUNT) {
+		return g_device_registers[addr];
+	}
+	if (addr >= MOTOR_REGISTER_BASE && addr < MOTOR_REGISTER_BASE + MOTOR_REGISTER_COUNT) {
+		return ((uint8_t *)g_motor_profiles)[addr - MOTOR_REGISTER_BASE];
+	}
+	if (addr >= STATUS_REGISTER_BASE && addr < TASK_STAT_REGISTER_BASE) {
+		value = g_comm_stats[(addr - STATUS_REGISTER_BASE) >> 1];
+	} else if (addr >= TASK_STAT_REGISTER_BASE && addr < DOSE_STAT_REGISTER_BASE) {
+		value = g_task_stats[(addr - TASK_STAT_REGISTER_BASE) >> 1];
+	} else if (addr >= DOSE_STAT_REGISTER_BASE && addr < STATUS_REGISTER_BASE + STATUS_REGISTER_COUNT) {
+		value = dose_queue_stat((addr - DOSE_STAT_REGISTER_BASE) >> 1);
+	} else {
+		return 0;
+	}
+	return (addr & 1) ? (uint8_t)(value >> 8) : (uint8_t)value;
+}
+
+/**
+ * @brief 읽기 범위 [start, start + count)에 태스크 상태 레지스터가 있으면 먼저 갱신합니다.
+ * 스택 검사가 있어 인터럽트를 막기 전에 부릅니다.
+ */
+static void refresh_task_stats(uint8_t start, uint8_t count) {
+	if (count != 0 && start + count > TASK_STAT_REGISTER_BASE
+			&& start < DOSE_STAT_REGISTER_BASE) {
+		task_stats_update();
+	}
+}
+
+
+/**
+ * @brief 'W' 명령: 레지스터에 값을 쓰고 쓴 값을 응답합니다.
+ * @param buffer 검증된 전체 패킷
+ */
+static void handle_write(uint8_t *buffer, uint8_t length) {
+	uint8_t addr = buffer[FRAME_IDX_ADDR];
+	uint8_t data = buffer[FRAME_IDX_W_DATA];
+
+	if (addr == STATUS_REGISTER_BASE) { // 통신 카운터 초기화
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+			for (uint8_t i = 0; i < COMM_STAT_COUNT; i++) {
+				g_comm_stats[i] = 0;
+			}
+		}
+	} else {
+		write_register(addr, data); // 가상 레지스터, 투여 프로파일 (그 외 주소는 무시)
+	}
+	// 'W' 명령에 대한 응답
+	send_response(buffer[FRAME_IDX_ID], 'W', addr, data);
+}
+
+/**
+ * @brief 'R' 명령: 레지스터 값을 읽어 응답합니다.
+ * @param buffer 검증된 전체 패킷
+ */
+static void handle_read(uint8_t *buffer, uint8_t length) {
+	uint8_t addr = buffer[FRAME_IDX_ADDR];
+	uint8_t data;
+
+	refresh_task_stats(addr, 1);
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		data = read_register(addr);
+	}
+	// 'R' 명령에 대한 응답
+	send_response(buffer[FRAME_IDX_ID], 'R', addr, data);
+}
+
+/**
+ * @brief 'D' 명령: 펌프 투여를 시작(투여량 0이면 정지)하고 바로 응답합니다.
+ * 투여는 Tick Hook이 끝내므로 투여 중에도 다른 명령에 계속 응답할 수 있습니다.
+ * @param buffer 검증된 전체 패킷
+ */
+static void handle_dose(uint8_t *buffer, uint8_t length) {
+	uint8_t channel = buffer[FRAME_IDX_D_CHANNEL];
+	uint8_t volume = buffer[FRAME_IDX_D_VOLUME];
+
+	if (!motor_dose_volume(channel, volume)) {
+		volume = 0; // 잘못된 채널: 투여량 0으로 응답
+	}
+	send_response(buffer[FRAME_IDX_ID], 'D', channel, volume);
+}
+
+/**
+ * @brief 'r' 명령: 연속된 레지스터를 한 번에 읽어 하나의 응답 프레임으로 보냅니다.
+ * 응답: $ ID 'r' Start Count Data[Count] Checksum \n (Count는 실제 읽은 수)
+ * @param buffer 검증된 전체 패킷
+ */
+static void handle_bulk_read(uint8_t *buffer, uint8_t length) {
+	uint8_t response[FRAME_LENGTH(4 + PROTOCOL_MAX_BULK)];
+	uint8_t start = buffer[FRAME_IDX_BULK_START];
+	uint8_t count = clip_read_count(start, buffer[FRAME_IDX_BULK_COUNT]);
+
+	response[FRAME_IDX_ID] = buffer[FRAME_IDX_ID];
+	response[FRAME_IDX_CMD] = 'r';
+	response[FRAME_IDX_BULK_START] = start;
+	response[FRAME_IDX_BULK_COUNT] = count;
+	refresh_task_stats(start, count);
+	// 카운터를 같은 시점에서 읽도록 복사 동안 인터럽트 금지 (최대 PROTOCOL_MAX_BULK 바이트)
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		for (uint8_t i = 0; i < count; i++) {
+			response[FRAME_IDX_BULK_DATA + i] = read_register(start + i);
+		}
+	}
+
+	send_frame(response, FRAME_IDX_BULK_DATA - 1 + count);
+}
+
+/**
+ * @brief 'w' 명령: 연속된 레지스터에 한 번에 씁니다.
+ * 응답: $ ID 'w' Start Count Checksum \n (Count는 실제 쓴 수)
+ * @param buffer 검증된 전체 패킷 (길이는 Count로 결정되며 여기서 검사)
+ */
+static void handle_bulk_write(uint8_t *buffer, uint8_t length) {
+	uint8_t start = buffer[FRAME_IDX_BULK_START];
+	uint8_t count = buffer[FRAME_IDX_BULK_COUNT];
+
+	// 길이 확인: '$', ID, Cmd, Start, Count, Data[Count], Checksum, '\n'
+	if (length != protocol_frame_length(buffer, length)) {
+		COMM_STAT_INC(COMM_STAT_BAD_LENGTH);
+		return;
+	}
+
+	count = clip_register_count(start, count);
+	for (uint8_t i = 0; i < count; i++) {
+		write_register(start + i, buffer[FRAME_IDX_BULK_DATA + i]);
 	}
+
+	send_response(buffer[FRAME_IDX_ID], 'w', start, count);
+}
+
+/**
+ * @brief 'B' 명령: 현재 보율로 응답한 뒤 송신이 끝나면 새 보율로 전환합니다.
+ * 새 보율로 유효한 프레임이 PROTOCOL_BAUD_CONFIRM_MS 안에 오지 않으면 UART가 9600으로 복귀합니다.
+ * @param buffer 검증된 전체 패킷
+ */
+static void handle_baud(uint8_t *buffer, uint8_t length) {
+	uint8_t code = buffer[FRAME_IDX_B_CODE];
+
+	if (code >= PROTOCOL_BAUD_CODE_COUNT) {
+		send_response(buffer[FRAME_IDX_ID], 'B', code, 0);
+		return;
+	}
+
+	uart_change_baud_after_tx(pgm_read_dword(&baud_table[code]), PROTOCOL_BAUD_CONFIRM_MS);
+	send_response(buffer[FRAME_IDX_ID], 'B', code, 1);
+}
+
+/**
+ * @brief 'Q' 명령: 투여 작업을 큐 끝에 넣고 바로 응답합니다 (개수 0이면 큐를 비우고 실행 중인 작업을 멈춤).
+ * 작업은 Tick Hook이 순서대로 실행하므로 Master는 레시피 전체를 연달아 보내고 상태 레지스터로 진행을 확인합니다.
+ * 응답: $ ID 'Q' 넣은개수 대기작업수 Checksum \n (큐가 차거나 채널이 잘못된 작업부터는 넣지 않음)
+ * @param buffer 검증된 전체 패킷 (길이는 Count로 결정되며 여기서 검사)
+ */
+static void handle_queue(uint8_t *buffer, uint8_t length) {
+	uint8_t count = buffer[FRAME_IDX_Q_COUNT];
+	uint8_t accepted = 0;
+	uint8_t depth;
+
+	// 길이 확인: '$', ID, Cmd, Count, Job[Count], Checksum, '\n'
+	if (length != protocol_frame_length(buffer, length)) {
+		COMM_STAT_INC(COMM_STAT_BAD_LENGTH);
+		return;
+	}
+
+	if (count == 0) {
+		dose_queue_clear();
+	}
+	while (accepted < count && dose_queue_push(&buffer[FRAME_IDX_Q_JOBS + accepted * DOSE_JOB_SIZE])) {
+		accepted++;
+	}
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		depth = (uint8_t)dose_queue_stat(DOSE_STAT_DEPTH);
+	}
+	send_response(buffer[FRAME_IDX_ID], 'Q', accepted, depth);
 }
 
 
 /**
  * @brief 수신된 패킷을 파싱하고 처리합니다. (Slave 로직) 
+ * 명령 바이트로 디스패치 테이블을 바로 인덱싱하여 길이, 체크섬 범위, 처리 함수를 얻습니다.
  * @param buffer 수신된 전체 패킷 ('$'...'\n' 포함)
  * @param length 패킷의 전체 길이
  */
 void process_packet(uint8_t *buffer, uint8_t length) {
-	// 1. 최소 길이 확인 (W: 7바이트, R: 6바이트)
-	if (length < 6) return; // 너무 짧음
+	const command_entry_t *entry;
+	command_handler_t handler;
+	uint8_t index;
+	uint8_t frame_length;
+	uint8_t checksum_span;
+
+	// 1. 최소 길이 확인 (가장 짧은 'R' 명령)
+	if (length < FRAME_LENGTH(3)) { // 너무 짧음
+		COMM_STAT_INC(COMM_STAT_BAD_LENGTH);
+		return;
+	}
 
 	// 2. Slave ID 확인
-	uint8_t slave_id = buffer[FRAME_IDX_ID];
-	if (slave_id != MY_SLAVE_ID) {
+	if (buffer[FRAME_IDX_ID] != MY_SLAVE_ID) {
 		return; // 이 장치를 위한 패킷이 아님
 	}
 
-	// 3. 체크섬 확인
-	uint8_t cmd = buffer[FRAME_IDX_CMD];
-	uint8_t addr = buffer[FRAME_IDX_ADDR];
-	uint8_t received_checksum;
-	uint8_t calculated_checksum;
-	uint8_t data_len_for_checksum;
-
-	if (cmd == 'W') {
-		
-		if (length != 7) return; // 'W' 명령은 7바이트여야 함
-		received_checksum = buffer[FRAME_IDX_W_CHECKSUM];
-		data_len_for_checksum = 4; // ID, Cmd, Addr, Data
-		
-		} else if (cmd == 'R') {
-		
-		if (length != 6) return; // 'R' 명령은 6바이트여야 함  (Data 필드 없음)
-		received_checksum = buffer[length - 2]; // Checksum은 \n 바로 앞
-		data_len_for_checksum = 3; // ID, Cmd, Addr
-		
-		} else {
-		return; // 알 수 없는 명령
-	}
-	
-	calculated_checksum = calculate_checksum(&buffer[FRAME_IDX_ID], data_len_for_checksum);
-
-	if (received_checksum != calculated_checksum) {
-		return; // 체크섬 오류
-		}else{
-		// 4. 유효성 검사 통과 -> 명령 처리
-		uint8_t data;
-		if (cmd == 'W') {
-			data = buffer[FRAME_IDX_W_DATA];
-			if (addr < 16) { // 가상 레지스터 범위 확인
-				g_device_registers[addr] = data;
-			}
-			// 'W' 명령에 대한 응답
-			send_response(slave_id, cmd, addr, data);
-			
-			} else if (cmd == 'R') {
-			data = 0;
-			if (addr < 16) { // 가상 레지스터 범위 확인
-				data = g_device_registers[addr];
-			}
-			// 'R' 명령에 대한 응답
-			send_response(slave_id, cmd, addr, data);
-		}
+	// 3. 명령 조회 (테이블 범위 밖이면 알 수 없는 명령)
+	index = (uint8_t)(buffer[FRAME_IDX_CMD] - PROTOCOL_CMD_FIRST);
+	if (index >= PROTOCOL_CMD_COUNT) {
+		COMM_STAT_INC(COMM_STAT_BAD_LENGTH);
+		return;
 	}
+	entry = &command_table[index];
 
+	// 4. 길이 확인 (정의되지 않은 명령은 길이 0이라 여기서 걸러짐)
+	frame_length = pgm_read_byte(&entry->frame_length);
+	if (frame_length == FRAME_LENGTH_VARIABLE) {
+		checksum_span = length - FRAME_LENGTH(0); // ID부터 Checksum 앞까지 전체
+	} else if (length == frame_length) {
+		checksum_span = pgm_read_byte(&entry->checksum_span);
+	} else {
+		COMM_STAT_INC(COMM_STAT_BAD_LENGTH);
+		return;
+	}
 
-}
\ No newline at end of file
+#if PROTOCOL_USE_CRC16
+	// 5. CRC는 수신 ISR(frame.c)에서 바이트마다 갱신되어 '\n'에서 이미 검증됨
+	(void)checksum_span;
+#else
+	// 5. 체크섬 확인 (Checksum은 \n 바로 앞)
+	if (buffer[length - 2] != calculate_checksum(&buffer[FRAME_IDX_ID], checksum_span)) {
+		// 이스케이프 오류도 같은 카운터를 수신 ISR에서 올리므로 인터럽트를 막고 증가
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+			COMM_STAT_INC(COMM_STAT_BAD_CHECKSUM);
+		}
+		return; // 체크섬 오류
+	}
+#endif
+
+	// 6. 유효성 검사 통과 -> 명령 처리 (보율 변경 직후라면 새 보율 확인)
+	uart_baud_confirm();
+	handler = (command_handler_t)pgm_read_ptr(&entry->handler);
+	handler(buffer, length);
+}
@@ -4,11 +4,107 @@
 //0x24   0x01  0x57  0x05  0xAA     0x07     0x0A
 // $   SlaveId  R    주소  checkSum값  \n
 //0x24  0x01   0x52  0x05  0x58      0x0A
+// $   SlaveId  D    채널  투여량(mL, 0이면 정지)  checkSum값  \n
+//0x24  0x01   0x44  0x00  0x64                  0xA9      0x0A
+// $   SlaveId  r    시작주소  개수  checkSum값  \n            (연속 레지스터 읽기)
+//0x24  0x01   0x72  0x00     0x10  0x83        0x0A
+//  응답: $ SlaveId r 시작주소 개수 데이터[개수] checkSum값 \n  (개수는 실제 읽은 수)
+// $   SlaveId  w    시작주소  개수  데이터[개수]  checkSum값  \n (연속 레지스터 쓰기)
+//  응답: $ SlaveId w 시작주소 개수 checkSum값 \n              (개수는 실제 쓴 수)
+// $   SlaveId  B    보율코드  checkSum값  \n                    (보율 변경)
+//0x24  0x01   0x42  0x05     0x48        0x0A
+//  응답(현재 보율): $ SlaveId B 보율코드 성공(1)/실패(0) checkSum값 \n
+//  응답 송신 후 새 보율로 전환하며, PROTOCOL_BAUD_CONFIRM_MS 안에 새 보율로
+//  유효한 프레임을 받지 못하면 9600으로 복귀합니다.
+//  보율코드: 0=9600 1=57600 2=115200 3=250000 4=500000 5=1000000
+// $   SlaveId  Q    개수  작업[개수]  checkSum값  \n              (투여 작업 큐에 추가, dose_queue.h)
+//  작업 = 채널, 투여량(mL), 대기(앞 작업이 끝난 뒤, 0.1초 단위) 3바이트. 개수 0이면 큐를 비우고 실행 중인 작업을 멈춤
+//0x24  0x01   0x51  0x02  0x00 0x0F 0x00  0x01 0x05 0x32  0x9B  0x0A   (채널 0 15mL, 5초 뒤 채널 1 5mL)
+//  응답: $ SlaveId Q 넣은개수 대기작업수 checkSum값 \n         (큐가 차거나 채널이 잘못되면 그 앞까지만 넣음)
+//
+// PROTOCOL_USE_CRC16 = 1 이면 모든 프레임의 checkSum값(1바이트 합)이
+// CRC-16/MODBUS 2바이트(하위, 상위 순)로 바뀝니다. 범위는 동일하게 SlaveId부터 checkSum 앞까지.
+// CRC 바이트는 0x0A/0x24가 될 수 있으므로 PROTOCOL_USE_ESCAPE = 1 과 함께만 사용합니다 (아니면 컴파일 오류).
+// $   SlaveId  R    주소  CRC_L  CRC_H  \n
+//
+// PROTOCOL_USE_ESCAPE = 1 이면 '$'와 '\n' 사이의 바이트(SlaveId ~ checkSum) 중
+// '$'(0x24), '\n'(0x0A), ESC(0x7D)는 ESC, (값 ^ 0x20) 두 바이트로 보냅니다 (HDLC 방식).
+// 데이터/체크섬이 0x0A여도 프레임이 잘리지 않습니다. 길이와 체크섬은 복원된 바이트 기준.
+// $   SlaveId  W    주소  쓰기값          checkSum값  \n
+//0x24  0x01   0x57  0x05  0x7D 0x2A       0x67      0x0A   (쓰기값 0x0A)
+//
+// 수신 중 '$'를 받으면 진행 중인 프레임을 버리고 그 '$'부터 새 프레임을 시작합니다.
+// PROTOCOL_USE_ESCAPE = 0 이면 데이터/checkSum값도 0x24일 수 있으므로, 명령(과 가변 길이 명령의 개수)으로
+// 정해지는 길이 안의 데이터/checkSum 자리에 온 '$'는 데이터로 받고, SlaveId/명령/개수 자리이거나
+// 프레임 길이를 넘은 '$'에서만 다시 시작합니다. 데이터 자리의 '$' 뒤에 프레임이 끊기면 시간 초과로 버립니다.
+// 프레임 도중 PROTOCOL_FRAME_TIMEOUT_MS 이상 바이트가 끊기면 부분 프레임을 버립니다.
+// SlaveId가 MY_SLAVE_ID가 아닌 프레임은 수신 ISR에서 ID 바이트를 받는 즉시 버립니다.
+//
+// PROTOCOL_USE_9BIT = 1 이면 9비트 UART(MPCM)를 사용합니다. Master는 각 프레임 앞에
+// 9번째 비트가 1인 주소 바이트(SlaveId)를 보내고, 프레임 바이트는 9번째 비트 0으로 보냅니다.
+// 주소가 다른 Slave는 '\n'까지 하드웨어에서 걸러지므로 수신 인터럽트가 발생하지 않습니다.
+// [주소(9비트=1)=SlaveId] $ SlaveId R 주소 checkSum값 \n
+//
+// 투여 프로파일 레지스터 (읽기/쓰기, W/R/w/r): 0x40부터 채널마다 MOTOR_PROFILE_SIZE 바이트
+// (본 구간 속도, 마무리 구간 속도, 마무리 구간 투여량 0.1mL, motor.h). 다음 'D' 명령부터 적용.
+// $   SlaveId  w    0x40  0x03  0xFF 0x40 0x14  checkSum값  \n   (채널 0: 최대 속도, 마지막 2.0mL는 1/4 속도)
+//
+// 상태 레지스터 (읽기 전용, R/r 명령으로 읽기): 0x80부터 통신 카운터 COMM_STAT_*
+// 16비트 카운터마다 하위, 상위 바이트 순 (0x80,0x81 = 하드웨어 오버런 ...).
+// r 명령 한 번(최대 PROTOCOL_MAX_BULK 바이트)으로 읽은 카운터는 같은 시점의 값입니다. 0x80에 W하면 카운터 전체를 0으로.
+// $   SlaveId  r    0x80  0x10  checkSum값  \n   (카운터 8개, 0x90부터 나머지)
+// 카운터 다음(0x92~)은 태스크 상태 TASK_STAT_* (같은 16비트 형식): CPU 사용률과 스택 최소 여유.
+// 읽을 때 직전 갱신에서 TASK_STATS_WINDOW_MS 이상 지났으면 새로 계산하므로, 그 사이의 읽기는 같은 값입니다.
+// $   SlaveId  r    0x92  0x08  checkSum값  \n   (태스크 상태 전체)
+// 그다음(0x9A~)은 투여 작업 큐 상태 DOSE_STAT_* (같은 16비트 형식): 대기 작업 수, 현재 작업.
+// $   SlaveId  r    0x9A  0x08  checkSum값  \n   (큐 상태 전체)
 
+#ifndef PROTOCOL_H_
+#define PROTOCOL_H_
+
+#include <stdint.h>
 
 // --- 프로토콜 정의 ---
+#ifndef PROTOCOL_USE_CRC16
+#define PROTOCOL_USE_CRC16      0     // 1: CRC-16/MODBUS 프레임 (PROTOCOL_USE_ESCAPE 필요), 0: 8비트 합 체크섬 (기존 Master 호환)
+#endif
+
+#ifndef PROTOCOL_USE_ESCAPE
+#define PROTOCOL_USE_ESCAPE     0     // 1: '$', '\n', ESC 바이트 이스케이프 (투명 프레이밍), 0: 기존 Master 호환
+#endif
+
+// CRC 두 바이트 중 하나가 '\n'이면 프레임이 잘리므로 (8비트 합의 약 2배) 이스케이프 없이는 쓸 수 없음
+#if PROTOCOL_USE_CRC16 && !PROTOCOL_USE_ESCAPE
+#error "PROTOCOL_USE_CRC16 requires PROTOCOL_USE_ESCAPE = 1"
+#endif
+
+#ifndef PROTOCOL_USE_9BIT
+#define PROTOCOL_USE_9BIT       0     // 1: 9비트 주소 바이트 + MPCM 하드웨어 필터, 0: 8N1 (기존 Master 호환)
+#endif
+
+#ifndef PROTOCOL_FRAME_TIMEOUT_MS
+#define PROTOCOL_FRAME_TIMEOUT_MS 5   // 프레임 중간 무신호 허용 시간 (9600bps에서 약 5바이트 시간)
+#endif
+
+#define FRAME_ESCAPE            0x7D  // 이스케이프 문자
+#define FRAME_ESCAPE_XOR        0x20  // 이스케이프된 바이트 = 원래 값 ^ FRAME_ESCAPE_XOR
+#define FRAME_NEEDS_ESCAPE(b)   ((b) == '$' || (b) == '\n' || (b) == FRAME_ESCAPE)
+
+#if PROTOCOL_USE_CRC16
+#define FRAME_CHECKSUM_SIZE     2
+#else
+#define FRAME_CHECKSUM_SIZE     1
+#endif
+
+// ID부터 checkSum 앞까지 payload 바이트인 프레임의 전체 길이 ('$', checkSum, '\n' 포함)
+#define FRAME_LENGTH(payload)   ((payload) + 2 + FRAME_CHECKSUM_SIZE)
+
 #define MY_SLAVE_ID             0x01  // 이 장치의 Slave ID
-#define PROTOCOL_BUFFER_SIZE    16    // 수신 패킷 버퍼 크기 ('$'...'\n' 포함)
+#define PROTOCOL_MAX_BULK       16    // 'r'/'w' 명령 한 번에 처리하는 최대 레지스터 수
+#define PROTOCOL_BUFFER_SIZE    FRAME_LENGTH(4 + PROTOCOL_MAX_BULK) // 수신 패킷 버퍼 크기 ('$'...'\n' 포함, 최대 'w' 프레임)
+#define DEVICE_REGISTER_COUNT   16    // 가상 레지스터 수 (Address 0x00 ~ 0x0F)
+#define MOTOR_REGISTER_BASE     0x40  // 투여 프로파일 레지스터 시작 주소
+#define MOTOR_REGISTER_COUNT    (MOTOR_CHANNEL_COUNT * MOTOR_PROFILE_SIZE) // motor.h
 
 // PDF 프레임 인덱스 정의 [cite: 29, 31]
 #define FRAME_IDX_START         0
@@ -22,12 +118,84 @@
 #define FRAME_IDX_R_DATA        4 // 읽기 응답(R)일 경우 데이터 위치
 #define FRAME_IDX_R_CHECKSUM    4
 #define FRAME_IDX_R_END         6
+
+#define FRAME_IDX_D_CHANNEL     3 // 투여 명령(D)일 경우 펌프 채널 위치
+#define FRAME_IDX_D_VOLUME      4 // 투여 명령(D)일 경우 투여량(mL) 위치
+
+#define FRAME_IDX_BULK_START    3 // 연속 명령(r/w)의 시작 주소 위치
+#define FRAME_IDX_BULK_COUNT    4 // 연속 명령(r/w)의 레지스터 개수 위치
+#define FRAME_IDX_BULK_DATA     5 // 연속 명령(w 요청, r 응답)의 데이터 시작 위치
+
+#define FRAME_LENGTH_VARIABLE   0xFF // 디스패치 테이블: 길이가 가변인 명령
+#define FRAME_LENGTH_UNKNOWN    0    // protocol_frame_length(): 길이를 정하는 바이트를 아직 받지 않음
+#define FRAME_LENGTH_INVALID    0xFE // protocol_frame_length(): 알 수 없는 명령 또는 너무 큰 개수
+
+#define FRAME_IDX_B_CODE        3 // 보율 변경 명령(B)의 보율코드 위치
+
+#define FRAME_IDX_Q_COUNT       3 // 작업 큐 명령(Q)의 작업 개수 위치
+#define FRAME_IDX_Q_JOBS        4 // 작업 큐 명령(Q)의 첫 작업 위치 (작업마다 DOSE_JOB_SIZE 바이트, dose_queue.h)
+#define PROTOCOL_MAX_QUEUE_JOBS ((4 + PROTOCOL_MAX_BULK - FRAME_IDX_Q_COUNT) / DOSE_JOB_SIZE) // 수신 버퍼에 들어가는 'Q' 작업 수 (dose_queue.h)
+#define PROTOCOL_BAUD_CODE_COUNT 6
+#define PROTOCOL_BAUD_CONFIRM_MS 1000 // 보율 변경 후 확인 프레임 대기 시간
+
+// 명령 디스패치 테이블 범위 (명령 바이트 0x40 ~ 0x7F: 영문 대/소문자)
+#define PROTOCOL_CMD_FIRST      0x40
+#define PROTOCOL_CMD_COUNT      64
+
+// 통신 카운터 (16비트, 0xFFFF 다음 0으로 순환). 괄호 안은 카운터를 올리는 문맥
+// BAD_CHECKSUM만 두 문맥에서 올라가므로 Task 쪽 증가는 인터럽트를 막고 합니다 (나머지는 한 문맥 전용)
+enum {
+	COMM_STAT_HW_OVERRUN,		// UART 하드웨어 오버런 (DOR0, 수신 ISR)
+	COMM_STAT_HW_FRAMING,		// 프레이밍/패리티 오류 바이트 (FE0/UPE0, 수신 ISR, 바이트는 버림)
+	COMM_STAT_RX_OVERFLOW,		// 빈 프레임 슬롯이 없어 버린 이 Slave 앞 프레임, 버퍼보다 긴 프레임 (수신 ISR, 프레임당 1)
+	COMM_STAT_FRAME_DROPPED,	// Task가 이전 프레임을 아직 가져가지 않아 버린 완성 프레임 (수신 ISR)
+	COMM_STAT_BAD_CHECKSUM,		// 체크섬 오류 (Task, 인터럽트 막고 증가), CRC/이스케이프 오류 (수신 ISR)
+	COMM_STAT_BAD_LENGTH,		// 길이 오류, 알 수 없는 명령 (Task)
+	COMM_STAT_FOREIGN_ID,		// 다른 Slave ID의 프레임 (수신 ISR, 9비트 모드에서는 하드웨어가 걸러 0)
+	COMM_STAT_FRAME_TIMEOUT,	// 바이트 사이 시간 초과로 버린 부분 프레임 (Tick Hook)
+	COMM_STAT_SERVED,			// 응답을 보낸 프레임 (Task)
+	COMM_STAT_COUNT
+};
+
+#define COMM_STAT_INC(id)       (g_comm_stats[id]++)
+
+// 태스크 상태 (16비트, task_stats.c가 Protocol Task 문맥에서 갱신). CPU는 ISR 시간을 포함합니다 (인터럽트된 Task에 합산).
+enum {
+	TASK_STAT_PROTO_CPU,		// Protocol Task CPU 사용률 (0.1% 단위, 0~1000)
+	TASK_STAT_PROTO_STACK,		// Protocol Task 스택 최소 여유 (바이트, 부팅 이후)
+	TASK_STAT_IDLE_CPU,			// Idle Task 비율 = CPU 여유 (0.1% 단위)
+	TASK_STAT_IDLE_STACK,		// Idle Task 스택 최소 여유 (바이트)
+	TASK_STAT_COUNT
+};
+
+// 투여 작업 큐 상태 (16비트, dose_queue.c가 Tick Hook 문맥에서 갱신)
+enum {
+	DOSE_STAT_DEPTH,			// 시작을 기다리는 작업 수 (0~DOSE_QUEUE_CAPACITY)
+	DOSE_STAT_STATE,			// DOSE_QUEUE_IDLE / WAITING / RUNNING / STARTING
+	DOSE_STAT_JOB,				// 현재 작업: 하위 바이트 채널, 상위 바이트 투여량(mL) (IDLE이면 0)
+	DOSE_STAT_DONE,				// 끝낸 작업 수
+	DOSE_STAT_COUNT
+};
+
+#define STATUS_REGISTER_BASE    0x80  // 읽기 전용 상태 레지스터 시작 주소
+#define TASK_STAT_REGISTER_BASE (STATUS_REGISTER_BASE + 2 * COMM_STAT_COUNT)
+#define DOSE_STAT_REGISTER_BASE (TASK_STAT_REGISTER_BASE + 2 * TASK_STAT_COUNT)
+#define STATUS_REGISTER_COUNT   (2 * (COMM_STAT_COUNT + TASK_STAT_COUNT + DOSE_STAT_COUNT))
 // ---------------------
 
+extern volatile uint16_t g_comm_stats[COMM_STAT_COUNT];
+extern uint16_t g_task_stats[TASK_STAT_COUNT];
+
 
 uint8_t calculate_checksum(uint8_t *buffer, uint8_t length);
 
+uint8_t protocol_frame_length(const uint8_t *frame, uint8_t received);
+
+uint8_t protocol_finish_frame(uint8_t *frame, uint8_t payload_length);
+
 void send_response(uint8_t slave_id, uint8_t cmd, uint8_t addr, uint8_t data);
 
 
- void process_packet(uint8_t *buffer, uint8_t length);
\ No newline at end of file
+ void process_packet(uint8_t *buffer, uint8_t length);
+
+#endif /* PROTOCOL_H_ */
@@ -0,0 +1,78 @@
+/*
+ * task_stats.c
+ *
+ * FreeRTOS run time stats (configGENERATE_RUN_TIME_STATS, 시간축은 timer.c의 micros())와
+ * 스택 최소 여유(high water mark)를 vTaskGetInfo()로 읽어 상태 레지스터 g_task_stats에 채웁니다.
+ * (uxTaskGetStackHighWaterMark()와 같은 값이지만 UBaseType_t(8비트)로 잘리지 않는 16비트)
+ * Master가 태스크 상태 레지스터를 읽을 때 Protocol Task가 호출하므로 따로 주기 Task가 필요 없습니다.
+ *
+ * 커널의 Task별 누적 시간(32비트 us)은 약 71분마다 순환하지만, 구간 차이만 쓰므로
+ * 갱신 간격이 71분보다 짧으면 결과가 맞습니다.
+ */ 
+
+#include "FreeRTOS/FreeRTOS.h"
+#include "FreeRTOS/task.h"
+#include "task_stats.h"
+
+#define TASK_STATS_WINDOW_US	((uint32_t)TASK_STATS_WINDOW_MS * 1000)
+
+enum { TASK_SLOT_PROTO, TASK_SLOT_IDLE, TASK_SLOT_COUNT };
+
+static uint32_t last_total;						// 직전 갱신 시점의 run time 카운터
+static uint32_t last_run[TASK_SLOT_COUNT];		// 직전 갱신 시점의 Task별 누적 실행 시간
+static uint8_t sampled = 0;
+
+/**
+ * @brief 구간 동안의 실행 시간을 0.1% 단위로 바꿉니다 (32비트 곱셈 넘침 없이).
+ */
+static uint16_t run_time_permille(uint32_t run, uint32_t total) {
+	if (run > total) {
+		run = total;
+	}
+	// run * 1000이 32비트를 넘지 않도록 두 값을 같이 줄임 (total < 2^22)
+	while (total >= (1UL << 22)) {
+		total >>= 1;
+		run >>= 1;
+	}
+	if (total == 0) {
+		return 0;
+	}
+	return (uint16_t)(run * 1000 / total);
+}
+
+void task_stats_update(void) {
+	TaskHandle_t tasks[TASK_SLOT_COUNT];
+	uint32_t run[TASK_SLOT_COUNT];
+	uint32_t total;
+	uint16_t stack[TASK_SLOT_COUNT];
+	TaskStatus_t status;
+
+	tasks[TASK_SLOT_PROTO] = xTaskGetCurrentTaskHandle();
+	tasks[TASK_SLOT_IDLE] = xTaskGetIdleTaskHandle();
+
+	// 스케줄러를 멈춰 Task 전환(누적 시간 갱신) 도중의 값을 읽지 않도록 함
+	vTaskSuspendAll();
+	total = portGET_RUN_TIME_COUNTER_VALUE();
+	if (sampled && total - last_total < TASK_STATS_WINDOW_US) {
+		xTaskResumeAll();
+		return;
+	}
+	for (uint8_t i = 0; i < TASK_SLOT_COUNT; i++) {
+		vTaskGetInfo(tasks[i], &status, pdTRUE, eReady); // 상태 조회는 생략
+		run[i] = status.ulRunTimeCounter;
+		stack[i] = status.usStackHighWaterMark;
+	}
+	xTaskResumeAll();
+
+	g_task_stats[TASK_STAT_PROTO_CPU] = run_time_permille(run[TASK_SLOT_PROTO] - last_run[TASK_SLOT_PROTO], total - last_total);
+	g_task_stats[TASK_STAT_IDLE_CPU] = run_time_permille(run[TASK_SLOT_IDLE] - last_run[TASK_SLOT_IDLE], total - last_total);
+	// StackType_t가 1바이트이므로 word = 바이트
+	g_task_stats[TASK_STAT_PROTO_STACK] = stack[TASK_SLOT_PROTO];
+	g_task_stats[TASK_STAT_IDLE_STACK] = stack[TASK_SLOT_IDLE];
+
+	last_total = total;
+	for (uint8_t i = 0; i < TASK_SLOT_COUNT; i++) {
+		last_run[i] = run[i];
+	}
+	sampled = 1;
+}
@@ -0,0 +1,20 @@
+/*
+ * task_stats.h
+ *
+ * FreeRTOS run time stats / 스택 최소 여유를 상태 레지스터(TASK_STAT_*)로 옮깁니다.
+ */ 
+
+
+#ifndef TASK_STATS_H_
+#define TASK_STATS_H_
+
+#include <stdint.h>
+#include "protocol.h"
+
+#define TASK_STATS_WINDOW_MS	1000	// CPU 사용률 계산 구간 (최소)
+
+// Protocol Task 전용: 직전 갱신에서 TASK_STATS_WINDOW_MS 이상 지났으면(또는 처음이면) g_task_stats를 갱신합니다.
+// CPU 사용률은 직전 갱신 이후 구간의 값입니다. 스택 검사 때문에 인터럽트를 막은 상태에서 부르지 않습니다.
+void task_stats_update(void);
+
+#endif /* TASK_STATS_H_ */
@@ -5,7 +5,11 @@
 #include <util/atomic.h>
 #include <stdint.h>
 
-void timer0_init(void);
+// FreeRTOS Tick (Timer1 CTC, 64 분주, 1ms)을 시간축으로 사용합니다. Timer0은 사용하지 않음.
+// 스케줄러 시작(vTaskStartScheduler) 후부터 증가합니다.
+void timer_tick(void);
 uint32_t millis(void);
 uint32_t micros(void);
-void delay(float ms);
\ No newline at end of file
+// 스케줄러가 돌고 인터럽트가 켜져 있으면 millis()로, 그 밖(스케줄러 시작 전/일시 중지, 인터럽트 금지)에는
+// Tick이 늘지 않거나 Tick Hook이 불리지 않을 수 있으므로 _delay_ms() 바쁜 대기로 기다립니다.
+void delay(uint32_t ms);
\ No newline at end of file
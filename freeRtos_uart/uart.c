@@ -1,36 +1,104 @@
 ﻿#include <avr/interrupt.h>
+#include <string.h>
 #include "uart.h"
+#include "frame.h"
 #include "FreeRTOS/FreeRTOS.h"
 #include "FreeRTOS/task.h"
-#include "FreeRTOS/queue.h"
 
 
-// 링 버퍼 변수 (사용자 정의 방식 그대로 유지)
-volatile uint8_t tx_buffer[USART_TX_BUFFER_SIZE];
-volatile uint8_t tx_head = 0;
-volatile uint8_t tx_tail = 0;
-volatile uint8_t rx_buffer[USART_RX_BUFFER_SIZE];
-volatile uint8_t rx_head = 0;
-volatile uint8_t rx_tail = 0;
+// 송신 링 버퍼 (생산자: uart_tx_frame, 소비자: UDRE ISR)
+uart_tx_ring_t tx_ring;
+
+// 송신 완료 후 적용할 보율 (uart_change_baud_after_tx)
+static volatile uint8_t baud_pending = 0;
+static volatile uint32_t baud_pending_value;
+// 새 보율 확인 대기 시간 (tick 단위, 0이면 대기 없음). 만료 시 BAUD로 복귀
+static volatile uint16_t baud_fallback_ticks = 0;
+static uint16_t baud_fallback_timeout_ticks;
+
+// uart_rx_frame()에서 블록된 태스크 (RX ISR이 Task Notification으로 깨움)
+static TaskHandle_t rx_waiting_task = NULL;
+
+// 송신 링 버퍼 공간을 기다리는 태스크 (UDRE ISR이 잔량이 USART_TX_LOW_WATER 이하가 되면 깨움)
+static volatile TaskHandle_t tx_waiting_task = NULL;
+
+// uart_tx_frame()이 한 번에 넣는 최대 바이트 수: low-water에서 깨어나면 항상 들어갈 크기
+#define TX_CHUNK_MAX (USART_TX_BUFFER_SIZE - 1 - USART_TX_LOW_WATER)
+
+#if PROTOCOL_USE_9BIT
+// MPCM 켜기/끄기. TXC0는 1을 쓰면 지워지므로 U2X0만 보존하여 기록
+#define UART_MPCM_SLEEP()	(UCSR0A = (UCSR0A & (1 << U2X0)) | (1 << MPCM0))
+#define UART_MPCM_WAKE()	(UCSR0A = (UCSR0A & (1 << U2X0)))
+#endif
+
+// 수신 오류 집계. 프레이밍/패리티 오류 바이트는 값이 깨졌으므로 버립니다 (1 반환).
+// 오버런은 앞선 바이트를 잃은 것이고 현재 바이트는 정상이므로 그대로 처리합니다.
+static inline uint8_t uart_rx_error(uint8_t status) {
+	if (status & (1 << DOR0)) {
+		COMM_STAT_INC(COMM_STAT_HW_OVERRUN);
+	}
+	if (status & ((1 << FE0) | (1 << UPE0))) {
+		COMM_STAT_INC(COMM_STAT_HW_FRAMING);
+		return 1;
+	}
+	return 0;
+}
 
 // 수신 완료 인터럽트 핸들러 (RX Complete)
+// 바이트를 큐로 옮기지 않고 ISR에서 바로 프레임을 조립하여, 완성된 프레임 단위로 한 번만 알림
 ISR(USART_RX_vect) {
+	// 오류 플래그는 UDR0을 읽기 전에 확인해야 함 (수신 FIFO의 현재 바이트에 대한 값)
+	uint8_t status = UCSR0A;
+#if PROTOCOL_USE_9BIT
+	// 9번째 비트는 UDR0보다 먼저 읽어야 함
+	uint8_t address = UCSR0B & (1 << RXB80);
 	uint8_t data = UDR0;
-	uint8_t next_head = (rx_head + 1) % USART_RX_BUFFER_SIZE;
 
-	// 버퍼 오버플로우 방지
-	if (next_head == rx_tail) {
+	if (uart_rx_error(status)) {
 		return;
 	}
 
-	rx_buffer[rx_head] = data;
-	rx_head = next_head;
+	if (address) {
+		// 주소 바이트: 내 주소면 데이터 수신 시작, 아니면 다음 주소 바이트까지 하드웨어 필터
+		if (data == MY_SLAVE_ID) {
+			UART_MPCM_WAKE();
+		} else {
+			UART_MPCM_SLEEP();
+		}
+		return;
+	}
+	if (data == '\n') {
+		// 프레임 끝: 다시 주소 바이트만 받음
+		UART_MPCM_SLEEP();
+	}
+#else
+	uint8_t data = UDR0;
+
+	if (uart_rx_error(status)) {
+		return;
+	}
+#endif
+
+	if (!frame_rx_byte(data)) {
+		return;
+	}
+
+	// 대기 중인 태스크를 즉시 깨우고, 더 높은 우선순위라면 ISR 종료 시 바로 전환
+	if (rx_waiting_task != NULL) {
+		BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+		vTaskNotifyGiveFromISR(rx_waiting_task, &xHigherPriorityTaskWoken);
+		if (xHigherPriorityTaskWoken != pdFALSE) {
+			taskYIELD();
+		}
+	}
 }
 
 
 // 송신 데이터 레지스터 비어 있음 인터럽트 핸들러 (Data Register Empty)
 ISR(USART_UDRE_vect) {
-	if (tx_head == tx_tail) {
+	uint8_t data;
+
+	if (!ring_pop(&tx_ring, &data)) {
 		// 송신할 데이터가 없으면 UDRE 인터럽트만 비활성화합니다.
 		UCSR0B &= ~(1 << UDRIE0);
 		// 방향 전환은 TX Complete ISR에서 처리됩니다.
@@ -38,18 +106,36 @@ ISR(USART_UDRE_vect) {
 	}
 
 	// 다음 데이터 송신
-	UDR0 = tx_buffer[tx_tail];
-	tx_tail = (tx_tail + 1) % USART_TX_BUFFER_SIZE;
+	UDR0 = data;
+
+	// 공간을 기다리는 태스크가 있으면 잔량이 기준 이하로 내려간 순간 한 번만 깨움
+	// (송신기가 쉬기 전에 다음 데이터를 채울 수 있도록 tick을 기다리지 않음)
+	if (tx_waiting_task != NULL
+			&& ring_used(&tx_ring) <= USART_TX_LOW_WATER) {
+		BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+		vTaskNotifyGiveFromISR(tx_waiting_task, &xHigherPriorityTaskWoken);
+		tx_waiting_task = NULL;
+		if (xHigherPriorityTaskWoken != pdFALSE) {
+			taskYIELD();
+		}
+	}
 }
 
 // 전송 완료 인터럽트 핸들러 (TX Complete) - RS-485 수신 모드 전환용
 ISR(USART_TX_vect) {
 	// 마지막 데이터 전송 완료 후 호출됨.
 	// 링 버퍼가 비어 있는지 (UDRE ISR에서 마지막 데이터가 UDR0에 써진 후) 확인
-	if (tx_head == tx_tail) {
+	if (ring_is_empty(&tx_ring)) {
 		// 송신 버퍼가 완전히 비었으므로, RS-485를 수신 모드로 전환합니다.
 		// 수신 모드 전환 (DE=LOW, ~RE=LOW)
 		RS485_PORT &= ~((1 << RS485_DE_PIN) | (1 << RS485_RE_PIN));
+
+		// 응답 전송이 끝났으므로 예약된 보율로 전환하고 확인 대기 시작
+		if (baud_pending) {
+			baud_pending = 0;
+			uart_set_baud(baud_pending_value);
+			baud_fallback_ticks = baud_fallback_timeout_ticks;
+		}
 	}
 
 }
@@ -59,10 +145,43 @@ ISR(USART_TX_vect) {
 // 4. UART/RS-485 드라이버 구현
 // -----------------------------------------------------------
 
+void uart_set_baud(uint32_t baud) {
+	// U2X(배속) 모드: 16MHz에서 250k/500k/1M이 오차 0%, 나머지는 반올림으로 오차 최소화
+	uint16_t ubrr = (uint16_t)((F_CPU + 4 * baud) / (8 * baud) - 1);
+
+	// TXC0는 1을 쓰면 지워지므로 |= 대신 MPCM0만 보존하여 기록
+	UCSR0A = (UCSR0A & (1 << MPCM0)) | (1 << U2X0);
+	UBRR0H = (uint8_t)(ubrr >> 8);
+	UBRR0L = (uint8_t)ubrr;
+}
+
+void uart_change_baud_after_tx(uint32_t baud, uint16_t timeout_ms) {
+	taskENTER_CRITICAL();
+	baud_pending_value = baud;
+	baud_fallback_timeout_ticks = timeout_ms / portTICK_PERIOD_MS;
+	baud_pending = 1;
+	taskEXIT_CRITICAL();
+}
+
+void uart_baud_confirm(void) {
+	taskENTER_CRITICAL();
+	baud_fallback_ticks = 0;
+	taskEXIT_CRITICAL();
+}
+
+// Tick Hook (ISR 문맥): 수신 중인 프레임의 무신호 시간 측정,
+// 새 보율에서 유효한 프레임을 받지 못한 채 시간이 지나면 기본 보율로 복귀
+void uart_tick(void) {
+	frame_tick();
+
+	if (baud_fallback_ticks != 0 && --baud_fallback_ticks == 0) {
+		uart_set_baud(BAUD);
+	}
+}
+
 void uart_init(uint32_t baud) {
 	// 보율 설정
-	UBRR0H = (uint8_t)(UBRR_VALUE >> 8);
-	UBRR0L = (uint8_t)UBRR_VALUE;
+	uart_set_baud(baud);
 	
 	// RX/TX, RXCIE0 활성화
 	// TXCIE0 (TX Complete Interrupt Enable) 활성화 추가
@@ -70,6 +189,12 @@ void uart_init(uint32_t baud) {
 	
 	// 8N1 설정
 	UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
+
+#if PROTOCOL_USE_9BIT
+	// 9N1 설정 (송신은 TXB80=0 데이터 바이트), 주소 바이트를 기다리는 MPCM 상태로 시작
+	UCSR0B |= (1 << UCSZ02);
+	UART_MPCM_SLEEP();
+#endif
 	
 	// RS-485 핀 초기화 및 출력 설정
 	RS485_DDR |= (1 << RS485_DE_PIN) | (1 << RS485_RE_PIN);
@@ -81,47 +206,74 @@ void uart_init(uint32_t baud) {
 	UCSR0A |= (1 << TXC0);
 }
 
-void uart_tx(uint8_t data) {
-	uint8_t next_head;
-	
-	// 1. 송신 모드 활성화 (데이터를 버퍼에 넣기 전에 즉시 TX 모드로 전환)
-	// (DE=HIGH, ~RE=HIGH)
-	RS485_PORT |= (1 << RS485_DE_PIN) | (1 << RS485_RE_PIN);
-	
-	// 2. 링 버퍼에 쓰기 (Non-blocking: FreeRTOS Task를 Block)
-	while (1) {
-		next_head = (tx_head + 1) % USART_TX_BUFFER_SIZE;
-		
-		if (next_head != tx_tail) {
-			break; // 버퍼에 공간이 있다면 루프 탈출
+void uart_tx_frame(const uint8_t *data, uint8_t length) {
+	uint8_t chunk, space;
+
+	while (length > 0) {
+		// 1. 공간 확보: 한 번에 넣을 만큼(프레임 전체, 긴 출력은 TX_CHUNK_MAX씩)이 빌 때까지 대기
+		chunk = (length < TX_CHUNK_MAX) ? length : TX_CHUNK_MAX;
+		while (1) {
+			taskENTER_CRITICAL();
+			space = ring_free(&tx_ring);
+			if (space < chunk) {
+				// 버퍼가 가득 찼다면, UDRE ISR이 잔량을 low-water까지 비우면 깨우도록 등록
+				// (그때도 송신기에는 USART_TX_LOW_WATER 바이트가 남아 있어 쉬지 않음)
+				tx_waiting_task = xTaskGetCurrentTaskHandle();
+			}
+			taskEXIT_CRITICAL();
+
+			if (space >= chunk) {
+				break;
+			}
+			// RX 알림과 같은 알림 값을 쓰므로 깨어나면 공간을 다시 확인합니다.
+			// (uart_rx_frame()도 Block 전에 항상 프레임을 먼저 확인하므로 알림이 섞여도 놓치지 않음)
+			ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 		}
-		
-		// 버퍼가 가득 찼다면, Task를 잠시 Block하여 CPU 양보
-		// 1틱(일반적으로 1ms) 대기하며 다른 Task가 UDRE ISR을 처리하도록 기회 제공
-		vTaskDelay(pdMS_TO_TICKS(1));
+
+		// 2. 복사: head 뒤의 빈 칸은 Task만 쓰므로 임계 구역 없이 채움 (ISR은 head까지만 읽음)
+		ring_put(&tx_ring, data, chunk);
+		data += chunk;
+		length -= chunk;
+
+		// 3. 송신 모드 전환(DE=HIGH, ~RE=HIGH), head 공개, UDRE 인터럽트 활성화를 한 번에.
+		// TX Complete ISR이 그 사이에 끼어들어 방향을 수신으로 되돌리는 일이 없도록 임계 구역에서 처리
+		taskENTER_CRITICAL();
+		RS485_PORT |= (1 << RS485_DE_PIN) | (1 << RS485_RE_PIN);
+		ring_commit(&tx_ring, chunk);
+		UCSR0B |= (1 << UDRIE0);
+		taskEXIT_CRITICAL();
 	}
+}
 
-	tx_buffer[tx_head] = data;
-	tx_head = next_head;
-	
-	// 3. UDRE 인터럽트 활성화 (송신 시작)
-	UCSR0B |= (1 << UDRIE0);
+void uart_tx(uint8_t data) {
+	uart_tx_frame(&data, 1);
 }
 
-uint8_t uart_rx() {
-	// RX 버퍼가 비어 있다면, Task를 Block하여 데이터가 올 때까지 대기
-	while (rx_head == rx_tail) {
-		// FreeRTOS 환경이므로 Polling 대신 Task를 Block/Delay해야 합니다.
-		// 여기서는 간단하게 1ms Delay를 사용합니다. (더 나은 방법은 Semaphore나 Task Notification 사용)
-		vTaskDelay(pdMS_TO_TICKS(1));
+uint8_t *uart_rx_frame(uint8_t *length) {
+	uint8_t *frame;
+
+	// 호출 태스크를 RX ISR의 알림 대상으로 등록 (최초 1회)
+	if (rx_waiting_task == NULL) {
+		taskENTER_CRITICAL();
+		rx_waiting_task = xTaskGetCurrentTaskHandle();
+		taskEXIT_CRITICAL();
 	}
-	uint8_t data = rx_buffer[rx_tail];
-	rx_tail = (rx_tail + 1) % USART_RX_BUFFER_SIZE;
-	return data;
-}
 
-uint8_t uart_is_available() {
-	return (rx_head != rx_tail);
+	// 완성된 프레임이 없다면, ISR의 알림이 올 때까지 Task를 Block (CPU 사용 없음)
+	// 알림은 누적되므로 검사와 Block 사이에 완성된 프레임도 놓치지 않습니다.
+	taskENTER_CRITICAL();
+	frame = frame_take(length);
+	taskEXIT_CRITICAL();
+
+	if (frame == NULL) {
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+		// 프레임이 아닌 알림(Tick Hook의 투여 작업 알림, 늦게 온 송신 공간 알림)이면 NULL
+		taskENTER_CRITICAL();
+		frame = frame_take(length);
+		taskEXIT_CRITICAL();
+	}
+	return frame;
 }
 
 // 스케줄러 시작 전용 (폴링 방식)
@@ -135,8 +287,13 @@ void uart_initial_print(const char *s) {
 
 // Task 내부용 (인터럽트 방식)
 void uart_task_print(const char *s) {
-	while (*s) {
-		uart_tx(*s++);
+	size_t length = strlen(s);
+
+	while (length > 0) {
+		uint8_t chunk = (length < 0xFF) ? (uint8_t)length : 0xFF;
+		uart_tx_frame((const uint8_t *)s, chunk);
+		s += chunk;
+		length -= chunk;
 	}
 }
 
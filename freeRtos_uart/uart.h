@@ -1,10 +1,12 @@
-﻿#define F_CPU 16000000UL
-#define BAUD 9600
-#define UBRR_VALUE (F_CPU / 16 / BAUD - 1)
+﻿#include <stdint.h>
+#include "../common/ring.h"
+
+#define F_CPU 16000000UL
+#define BAUD 9600 // 기본 보율 (보율 변경 확인 실패 시 복귀 값)
 
 
 #define USART_TX_BUFFER_SIZE 256
-#define USART_RX_BUFFER_SIZE 64
+#define USART_TX_LOW_WATER (USART_TX_BUFFER_SIZE / 4) // 링 버퍼가 가득 차 Block된 송신 Task를 깨우는 잔량 (바이트)
 
 
 // RS-485 방향 제어 핀 정의
@@ -18,17 +20,15 @@
 // 2. UART/RS-485 드라이버 함수 선언
 // -----------------------------------------------------------
 void uart_tx(uint8_t data);
-uint8_t uart_rx();
-uint8_t uart_is_available();
+void uart_tx_frame(const uint8_t *data, uint8_t length); // 프레임 전체를 한 번에 송신 링 버퍼에 넣고 방향 전환/송신 시작은 한 번만
+uint8_t *uart_rx_frame(uint8_t *length); // 완성된 '$'...'\n' 프레임이나 Task 알림이 올 때까지 Block, 프레임 슬롯 반환 (다음 호출 전까지 유효, 프레임 없이 깨어나면 NULL)
 void uart_init(uint32_t baud);
+void uart_set_baud(uint32_t baud); // U2X 모드로 즉시 보율 변경
+void uart_change_baud_after_tx(uint32_t baud, uint16_t timeout_ms); // 송신 완료 후 보율 변경, timeout_ms 내 확인 없으면 BAUD로 복귀
+void uart_baud_confirm(void); // 새 보율에서 유효한 프레임을 받았음을 알림 (복귀 취소)
+void uart_tick(void); // Tick Hook에서 호출
 void uart_initial_print(const char *s); // 스케줄러 시작 전용 폴링 출력
 void uart_task_print(const char *s); // Task 내부 인터럽트 출력
 
-extern volatile uint8_t rx_buffer[USART_RX_BUFFER_SIZE];
-extern volatile uint8_t rx_head;
-extern volatile uint8_t rx_tail;
-
-
-extern volatile uint8_t tx_buffer[USART_TX_BUFFER_SIZE];
-extern volatile uint8_t tx_head;
-extern volatile uint8_t tx_tail;
\ No newline at end of file
+RING_DECLARE(uart_tx_ring_t, USART_TX_BUFFER_SIZE);
+extern uart_tx_ring_t tx_ring; // 송신 링 버퍼 (high_water/overruns 통계 포함)
\ No newline at end of file
@@ -1,11 +1,34 @@
 ﻿#include "uart.h"
 #include <avr/io.h>
 #include <util/delay.h>
+#include <util/atomic.h>
+#include "../../common/ring.h"
 
 #define USART_TX_BUFFER_SIZE 64
 #define USART_RX_BUFFER_SIZE 64
 #define F_CPU 16000000UL
 
+// 마지막 바이트의 정지 비트가 끝난 뒤 송신 모드를 유지할 시간 (us, 0이면 TXC 인터럽트에서 바로 수신 모드)
+// Timer2 one-shot(분주비 64, 4us 단위)으로 기다리므로 인터럽트를 막지 않습니다. 최대 1020us.
+#ifndef UART_TURNAROUND_GUARD_US
+#define UART_TURNAROUND_GUARD_US 0
+#endif
+#define UART_GUARD_TICKS (UART_TURNAROUND_GUARD_US / 4)
+
+#if UART_GUARD_TICKS > 255
+#error "UART_TURNAROUND_GUARD_US must be 1020us or less"
+#endif
+
+// UART_ISR_PROBE를 정의하면 UART ISR 실행 동안 PB5를 HIGH로 만듭니다.
+// 로직 분석기로 PB5의 HIGH 폭을 재면 ISR 안에서 인터럽트가 막혀 있는 시간을 측정할 수 있습니다.
+#ifdef UART_ISR_PROBE
+#define PROBE_ON()  (PORTB |= (1 << PB5))
+#define PROBE_OFF() (PORTB &= ~(1 << PB5))
+#else
+#define PROBE_ON()
+#define PROBE_OFF()
+#endif
+
 // RS-485 방향 제어 핀 정의
 #define RS485_PORT PORTD
 #define RS485_DDR DDRD
@@ -13,75 +36,125 @@
 #define RS485_DE_PIN PD3 // Directional Enable (Active High) 
 #define RS485_RE_PIN PD2 // Receive Enable (Active Low)
 
-volatile uint8_t tx_buffer[USART_TX_BUFFER_SIZE];
-volatile uint8_t tx_head = 0;
-volatile uint8_t tx_tail = 0;
-volatile uint8_t rx_buffer[USART_RX_BUFFER_SIZE];
-volatile uint8_t rx_head = 0;
-volatile uint8_t rx_tail = 0;
+// 송신 링 (생산자: uart_tx, 소비자: UDRE ISR), 수신 링 (생산자: RX ISR, 소비자: uart_rx)
+RING_DECLARE(uart_tx_ring_t, USART_TX_BUFFER_SIZE);
+RING_DECLARE(uart_rx_ring_t, USART_RX_BUFFER_SIZE);
+static uart_tx_ring_t tx_ring;
+static uart_rx_ring_t rx_ring;
 
 
 ISR(USART_RX_vect) {
-	uint8_t data = UDR0;
-	uint8_t next_head = (rx_head + 1) % USART_RX_BUFFER_SIZE;
+	// 가득 차면 바이트를 버리고 rx_ring.s.overruns 증가
+	ring_push(&rx_ring, UDR0);
+}
+
+ISR(USART_UDRE_vect) {
+	uint8_t data;
 
-	if (next_head == rx_tail) {
+	PROBE_ON();
+	if (!ring_pop(&tx_ring, &data)) {
+		// 송신할 데이터가 없으면 UDRE 인터럽트만 비활성화합니다.
+		// 방향 전환은 마지막 바이트가 실제로 나간 뒤 TX Complete ISR에서 처리됩니다.
+		UCSR0B &= ~(1 << UDRIE0);
+		PROBE_OFF();
 		return;
 	}
 
-	rx_buffer[rx_head] = data;
-	rx_head = next_head;
+	UDR0 = data;
+	PROBE_OFF();
 }
 
-ISR(USART_UDRE_vect) {
-	if (tx_head == tx_tail) {
-		UCSR0B &= ~(1 << UDRIE0);
-		// 전송 완료 대기 및 수신 모드 전환
-		loop_until_bit_is_set(UCSR0A, TXC0);
-		RS485_PORT &= ~((1 << RS485_DE_PIN) | (1 << RS485_RE_PIN));
-		UCSR0A |= (1 << TXC0);
-		return;
+// 수신 모드 전환 (DE=LOW, ~RE=LOW)
+static inline void rs485_release(void) {
+	RS485_PORT &= ~((1 << RS485_DE_PIN) | (1 << RS485_RE_PIN));
+}
+
+// 전송 완료 인터럽트 핸들러 (TX Complete) - 시프트 레지스터까지 비었을 때 한 번 호출됨
+ISR(USART_TX_vect) {
+	PROBE_ON();
+	// 그 사이 uart_tx()가 새 데이터를 넣었다면 송신 모드 유지
+	if (ring_is_empty(&tx_ring)) {
+#if UART_GUARD_TICKS > 0
+		// 보호 시간 뒤 Timer2 비교 일치 인터럽트에서 수신 모드로 전환
+		TCNT2 = 0;
+		TIFR2 = (1 << OCF2A);
+		TIMSK2 = (1 << OCIE2A);
+		TCCR2B = (1 << CS22); // 분주비 64로 시작
+#else
+		rs485_release();
+#endif
 	}
+	PROBE_OFF();
+}
 
-	UDR0 = tx_buffer[tx_tail];
-	tx_tail = (tx_tail + 1) % USART_TX_BUFFER_SIZE;
+#if UART_GUARD_TICKS > 0
+// 턴어라운드 보호 시간 만료 (one-shot)
+ISR(TIMER2_COMPA_vect) {
+	TCCR2B = 0;
+	TIMSK2 = 0;
+	if (ring_is_empty(&tx_ring)) {
+		rs485_release();
+	}
 }
+#endif
 
 void uart_init(uint32_t baud) {
 	UBRR0 = (F_CPU / 16 / baud) - 1;
 	UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
 	UCSR0B = (1 << RXEN0) | (1 << TXEN0);
-	UCSR0B |= (1 << RXCIE0);
+	UCSR0B |= (1 << RXCIE0) | (1 << TXCIE0); // TX Complete 인터럽트로 수신 모드 전환
 	
 	// RS-485 핀 초기화
 	RS485_DDR |= (1 << RS485_DE_PIN) | (1 << RS485_RE_PIN);
 	
 	// 기본 상태: 수신 모드 (DE=LOW, ~RE=LOW)
-	RS485_PORT &= ~((1 << RS485_DE_PIN) | (1 << RS485_RE_PIN));
+	rs485_release();
+
+	// TXC 플래그를 미리 클리어합니다 (1을 써서 클리어).
+	UCSR0A |= (1 << TXC0);
+
+#if UART_GUARD_TICKS > 0
+	// Timer2: CTC 모드, 정지 상태 (TX Complete ISR에서 시작)
+	TCCR2A = (1 << WGM21);
+	TCCR2B = 0;
+	OCR2A = UART_GUARD_TICKS - 1;
+#endif
+#ifdef UART_ISR_PROBE
+	DDRB |= (1 << PB5);
+#endif
 }
 
 void uart_tx(uint8_t data) {
-	// 송신 시작 전, 송신 모드 활성화 (DE=HIGH, ~RE=HIGH)
-	RS485_PORT |= (1 << RS485_DE_PIN) | (1 << RS485_RE_PIN);
-	
-	uint8_t next_head = (tx_head + 1) % USART_TX_BUFFER_SIZE;
-
-	while (next_head == tx_tail) { }
-
-	tx_buffer[tx_head] = data;
-	tx_head = next_head;
-	UCSR0B |= (1 << UDRIE0);
+	while (ring_free(&tx_ring) == 0) { }
+
+	ring_put(&tx_ring, &data, 1);
+
+	// 송신 모드 활성화 (DE=HIGH, ~RE=HIGH), head 공개, UDRE 인터럽트 활성화를 한 번에.
+	// TX Complete ISR(또는 보호 시간 만료)이 그 사이에 수신 모드로 되돌리지 않도록 원자적으로 처리
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+#if UART_GUARD_TICKS > 0
+		TCCR2B = 0; // 진행 중인 보호 시간 취소
+		TIMSK2 = 0;
+#endif
+		RS485_PORT |= (1 << RS485_DE_PIN) | (1 << RS485_RE_PIN);
+		ring_commit(&tx_ring, 1);
+		UCSR0B |= (1 << UDRIE0);
+	}
 }
 
 uint8_t uart_rx() {
-	while (rx_head == rx_tail) { }
-	uint8_t data = rx_buffer[rx_tail];
-	rx_tail = (rx_tail + 1) % USART_RX_BUFFER_SIZE;
+	uint8_t data;
+
+	while (!ring_pop(&rx_ring, &data)) { }
 	return data;
 }
 
 uint8_t uart_is_available() {
-	return (rx_head != rx_tail);
+	return !ring_is_empty(&rx_ring);
+}
+
+uint8_t uart_rx_overruns() {
+	return rx_ring.s.overruns;
 }
 
 void uart_print(const char *s) {
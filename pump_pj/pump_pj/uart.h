@@ -8,4 +8,5 @@ void uart_init(uint32_t baud);
 void uart_tx(uint8_t data);
 uint8_t uart_rx();
 uint8_t uart_is_available();
+uint8_t uart_rx_overruns(); // 수신 링이 가득 차 버린 바이트 수 (255에서 멈춤)
 void uart_print(const char *s);
\ No newline at end of file